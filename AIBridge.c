@@ -3,6 +3,19 @@
 // ReforgerAI Mod v1.0.0
 // ============================================================
 
+[BaseContainerProps()]
+class AIGroupPoolConfig
+{
+	[Attribute("OPFOR", UIWidgets.EditBox, "Facción del grupo")]
+	string m_sFaction;
+
+	[Attribute("infantry_squad", UIWidgets.EditBox, "Plantilla del grupo")]
+	string m_sTemplate;
+
+	[Attribute("2", UIWidgets.EditBox, "Grupos precargados de esta plantilla")]
+	int m_iSize;
+}
+
 class AIBridgeConfig : ScriptAndConfig
 {
 	[Attribute("http://localhost:8765", UIWidgets.EditBox, "URL del servicio IA")]
@@ -14,6 +27,51 @@ class AIBridgeConfig : ScriptAndConfig
 	[Attribute("30.0", UIWidgets.EditBox, "Timeout de petición HTTP (segundos)")]
 	float m_fRequestTimeout;
 
+	[Attribute("1", UIWidgets.EditBox, "Máximo de peticiones simultáneas al servicio IA")]
+	int m_iMaxInFlight;
+
+	[Attribute("1", UIWidgets.CheckBox, "Ajustar el intervalo de envío según la latencia medida")]
+	bool m_bAdaptiveTick;
+
+	[Attribute("15.0", UIWidgets.EditBox, "Intervalo máximo de envío con tick adaptativo (segundos)")]
+	float m_fMaxTickInterval;
+
+	[Attribute("1", UIWidgets.CheckBox, "Enviar solo cambios respecto al último estado confirmado")]
+	bool m_bDeltaState;
+
+	[Attribute("15", UIWidgets.EditBox, "Ticks entre snapshots completos (keyframes) en modo delta")]
+	int m_iKeyframeInterval;
+
+	[Attribute("5.0", UIWidgets.EditBox, "Desplazamiento mínimo para reenviar una posición (metros)")]
+	float m_fDeltaPositionThreshold;
+
+	[Attribute("10.0", UIWidgets.EditBox, "Ventana para fusionar contactos repetidos de un grupo (segundos)")]
+	float m_fContactCoalesceWindow;
+
+	[Attribute("0.5", UIWidgets.EditBox, "Separación mínima entre envíos urgentes (segundos)")]
+	float m_fUrgentMinSpacing;
+
+	[Attribute("8", UIWidgets.EditBox, "Coste máximo de comandos IA ejecutados por frame (spawn = 8, formación = 1)")]
+	int m_iCommandBudgetPerFrame;
+
+	[Attribute("2.0", UIWidgets.EditBox, "Tiempo máximo de ejecución de comandos IA por frame (ms)")]
+	float m_fCommandTimeBudgetMs;
+
+	[Attribute("250", UIWidgets.EditBox, "Espera antes de recoger un resultado pendiente del servicio (ms)")]
+	int m_iResultPollDelay;
+
+	[Attribute("0", UIWidgets.CheckBox, "Mantener grupos precargados ocultos para SPAWN_GROUP y refuerzos")]
+	bool m_bGroupPoolEnabled;
+
+	[Attribute("", UIWidgets.Object, "Tamaño del pool por facción/plantilla")]
+	ref array<ref AIGroupPoolConfig> m_aGroupPools;
+
+	[Attribute("5.0", UIWidgets.EditBox, "Intervalo de llenado del pool de grupos (segundos)")]
+	float m_fGroupPoolFillInterval;
+
+	[Attribute("0 0 0", UIWidgets.EditBox, "Posición fuera del mapa donde esperan los grupos del pool (obligatoria: 0 0 0 desactiva el pool)")]
+	vector m_vGroupPoolHoldingPosition;
+
 	[Attribute("1", UIWidgets.CheckBox, "Activar logs de depuración")]
 	bool m_bDebugMode;
 }
@@ -27,10 +85,14 @@ class AIBridge : ScriptComponent
 	private ref AIEventDispatcher m_EventDispatcher;
 	private ref AICommandReceiver m_CommandReceiver;
 	private ref AIGameMasterHelper m_GMHelper;
+	private ref AIRequestScheduler m_Scheduler;
+	private ref AIStateDelta m_Delta;
+	private ref AIPlayerCache m_PlayerCache;
 	private float m_fTickTimer;
 	private string m_sSessionId;
 	private int m_iTick;
 	private bool m_bActive;
+	private EAIEventUrgency m_ePendingUrgency;
 
 	// -------------------------------------------------------
 	static AIBridge GetInstance()
@@ -50,6 +112,12 @@ class AIBridge : ScriptComponent
 		m_EventDispatcher = new AIEventDispatcher(this);
 		m_CommandReceiver = new AICommandReceiver(this);
 		m_GMHelper = new AIGameMasterHelper(this);
+		m_Scheduler = new AIRequestScheduler(this);
+		m_Delta = new AIStateDelta(this);
+		m_PlayerCache = new AIPlayerCache(this);
+		AIGroupController.GetInstance().PreloadPrefabs();
+		if (m_Config.m_bGroupPoolEnabled)
+			AIGroupController.GetInstance().StartGroupPools(m_Config);
 
 		GetGame().GetCallqueue().CallLater(FirstTick, 3000, false);
 		Print("[ReforgerAI] Bridge iniciado. Sesión: " + m_sSessionId);
@@ -60,18 +128,42 @@ class AIBridge : ScriptComponent
 	{
 		if (!m_bActive) return;
 
+		m_CommandReceiver.ProcessQueue();
+
 		m_fTickTimer += timeSlice;
-		if (m_fTickTimer >= m_Config.m_fTickInterval)
-		{
-			m_fTickTimer = 0;
-			SendGameState();
-		}
+
+		// Eventos urgentes adelantan el próximo envío
+		float interval = m_Scheduler.GetInterval();
+		if (m_ePendingUrgency == EAIEventUrgency.IMMEDIATE)
+			interval = m_Config.m_fUrgentMinSpacing;
+		else if (m_ePendingUrgency == EAIEventUrgency.ELEVATED)
+			interval = Math.Min(interval, m_Config.m_fTickInterval);
+
+		if (m_fTickTimer < interval) return;
+
+		// Sin hueco libre: se espera a la respuesta en curso
+		if (!m_Scheduler.CanSend()) return;
+
+		m_fTickTimer = 0;
+		SendGameState();
+	}
+
+	// -------------------------------------------------------
+	// Un evento pide que el estado salga antes del próximo tick
+	void RequestEarlySend(EAIEventUrgency urgency)
+	{
+		if (urgency <= m_ePendingUrgency) return;
+		m_ePendingUrgency = urgency;
+
+		if (m_Config.m_bDebugMode && urgency == EAIEventUrgency.IMMEDIATE)
+			Print("[ReforgerAI] Evento urgente, adelantando envío");
 	}
 
 	// -------------------------------------------------------
 	void FirstTick()
 	{
-		SendGameState();
+		if (m_Scheduler.CanSend())
+			SendGameState();
 	}
 
 	// -------------------------------------------------------
@@ -79,14 +171,17 @@ class AIBridge : ScriptComponent
 	{
 		m_iTick++;
 		string stateJson = BuildGameStateJson();
+		m_ePendingUrgency = EAIEventUrgency.ROUTINE;
 
 		if (m_Config.m_bDebugMode)
 			Print("[ReforgerAI] Enviando estado tick " + m_iTick);
 
 		// Petición HTTP al servicio IA
 		RestContext ctx = GetGame().GetRestApi().GetContext(m_Config.m_sServiceURL);
+		AIPendingRequest req = m_Scheduler.Begin(m_iTick);
 		RestCallback cb = new RestCallback();
-		cb.m_Callback = OnAIResponse;
+		cb.m_Callback = req.OnResponse;
+		req.Attach(cb);
 		ctx.POST(cb, "/command", stateJson);
 	}
 
@@ -98,6 +193,9 @@ class AIBridge : ScriptComponent
 		// Obtener mapa actual
 		ChimeraWorld world = GetGame().GetWorld();
 
+		m_Delta.BeginTick(m_iTick);
+		bool delta = !m_Delta.IsKeyframe();
+
 		JsonWriteContext json = new JsonWriteContext();
 		json.WriteObjectBegin();
 		json.WriteFloat("timestamp", ts);
@@ -105,70 +203,90 @@ class AIBridge : ScriptComponent
 		json.WriteString("map", mapName);
 		json.WriteString("game_mode", "game_master");
 		json.WriteInt("tick", m_iTick);
+		json.WriteBool("urgent", m_ePendingUrgency == EAIEventUrgency.IMMEDIATE);
+		json.WriteBool("delta", delta);
+		if (delta)
+			json.WriteInt("base_tick", m_Delta.GetBaseTick());
 
 		// Serializar jugadores
 		json.WriteKey("players");
 		json.WriteArrayBegin();
-		array<int> players = new array<int>();
-		GetGame().GetPlayerManager().GetPlayers(players);
-		foreach (int pid : players)
+		foreach (int pid, AIPlayerRecord rec : m_PlayerCache.GetRecords())
 		{
-			IEntity playerEnt = GetGame().GetPlayerManager().GetPlayerControlledEntity(pid);
-			if (!playerEnt) continue;
-			SerializePlayer(json, pid, playerEnt);
+			if (!m_PlayerCache.Refresh(rec)) continue;
+			SerializePlayer(json, rec);
 		}
 		json.WriteArrayEnd();
 
+		// Con los jugadores ya refrescados: objetivos que cambian de manos
+		// entran como eventos en este mismo tick
+		AIMissionManager.GetInstance().UpdateObjectiveControl(m_PlayerCache, m_EventDispatcher);
+
 		// Serializar grupos IA
 		json.WriteKey("ai_groups");
 		json.WriteArrayBegin();
-		SerializeAllAIGroups(json);
+		AIGroupController.GetInstance().SerializeGroups(json, m_Delta);
 		json.WriteArrayEnd();
 
 		// Serializar misiones activas
 		json.WriteKey("active_missions");
 		json.WriteArrayBegin();
-		m_GMHelper.SerializeActiveMissions(json);
+		m_GMHelper.SerializeActiveMissions(json, m_Delta);
 		json.WriteArrayEnd();
 
 		// Eventos pendientes
 		json.WriteKey("events");
 		json.WriteArrayBegin();
-		m_EventDispatcher.FlushEvents(json);
+		m_EventDispatcher.FlushEvents(json, m_iTick);
 		json.WriteArrayEnd();
+		json.WriteKey("event_stats");
+		m_EventDispatcher.SerializeStats(json, m_iTick);
 
 		// Estado del mundo
 		json.WriteKey("world_state");
 		SerializeWorldState(json);
 
+		// Entidades desaparecidas desde la base (solo en modo delta)
+		if (delta)
+		{
+			json.WriteKey("removed");
+			m_Delta.WriteRemoved(json);
+		}
+		m_Delta.EndTick();
+
+		// Métricas del mod
+		json.WriteKey("mod_stats");
+		SerializeModStats(json);
+
 		json.WriteObjectEnd();
 		return json.GetResult();
 	}
 
 	// -------------------------------------------------------
-	private void SerializePlayer(JsonWriteContext json, int pid, IEntity ent)
+	private void SerializePlayer(JsonWriteContext json, AIPlayerRecord rec)
 	{
-		CharacterControllerComponent ctrl = CharacterControllerComponent.Cast(
-			ent.FindComponent(CharacterControllerComponent));
+		string id = rec.m_sId;
+		string faction = rec.GetFactionKey();
+		vector pos = rec.m_Entity.GetOrigin();
+		float health = rec.GetHealth();
+		bool alive = rec.IsAlive();
+		bool inVehicle = rec.IsInVehicle();
+
+		// La salud se compara en tramos de 5 para no reenviar por ruido
+		string signature = faction + "|" + Math.Round(health / 5.0) + "|" + alive.ToString() + "|" + inVehicle.ToString();
+		if (!m_Delta.ShouldWrite(AIStateDelta.SECTION_PLAYERS, id, pos, signature)) return;
 
 		json.WriteObjectBegin();
-		json.WriteString("id", "player_" + pid.ToString());
-		json.WriteString("name", GetGame().GetPlayerManager().GetPlayerName(pid));
-		json.WriteString("faction", GetEntityFaction(ent));
-		SerializePosition(json, "position", ent.GetOrigin());
-		json.WriteFloat("health", GetEntityHealth(ent));
-		json.WriteBool("alive", ctrl && !ctrl.IsDead());
-		json.WriteBool("in_vehicle", IsInVehicle(ent));
+		json.WriteString("id", id);
+		json.WriteString("name", rec.m_sName);
+		json.WriteString("faction", faction);
+		SerializePosition(json, "position", pos);
+		json.WriteFloat("health", health);
+		json.WriteBool("alive", alive);
+		json.WriteBool("in_vehicle", inVehicle);
 		json.WriteObjectEnd();
 	}
 
-	// -------------------------------------------------------
-	private void SerializeAllAIGroups(JsonWriteContext json)
-	{
-		// Iterar sobre grupos IA registrados en el GroupController
-		AIGroupController.GetInstance().SerializeGroups(json);
-	}
-
 	// -------------------------------------------------------
 	private void SerializeWorldState(JsonWriteContext json)
 	{
@@ -183,6 +301,25 @@ class AIBridge : ScriptComponent
 		json.WriteObjectEnd();
 	}
 
+	// -------------------------------------------------------
+	private void SerializeModStats(JsonWriteContext json)
+	{
+		json.WriteObjectBegin();
+		json.WriteKey("scheduler");
+		m_Scheduler.SerializeStats(json);
+		json.WriteKey("delta");
+		m_Delta.SerializeStats(json);
+		json.WriteKey("command_queue");
+		m_CommandReceiver.SerializeStats(json);
+		json.WriteKey("player_cache");
+		m_PlayerCache.SerializeStats(json);
+		json.WriteKey("group_cache");
+		AIGroupController.GetInstance().SerializeCacheStats(json);
+		json.WriteKey("group_pools");
+		AIGroupController.GetInstance().SerializePoolStats(json);
+		json.WriteObjectEnd();
+	}
+
 	// -------------------------------------------------------
 	private void SerializePosition(JsonWriteContext json, string key, vector pos)
 	{
@@ -195,46 +332,106 @@ class AIBridge : ScriptComponent
 	}
 
 	// -------------------------------------------------------
-	void OnAIResponse(int code, string data)
+	void OnAIResponse(int tick, int code, string data)
 	{
-		if (code != 200)
+		// 202: trabajo aceptado, el resultado se recoge después
+		if (code != 200 && code != 202)
 		{
+			m_Scheduler.Abort(tick);
+			DiscardTick(tick);
+
+			// 409: el servicio no tiene nuestra base delta, reenviar completo
+			if (code == 409)
+				m_Delta.RequestKeyframe();
+
 			if (m_Config.m_bDebugMode)
 				Print("[ReforgerAI] Error HTTP " + code);
 			return;
 		}
 
-		if (m_Config.m_bDebugMode)
-			Print("[ReforgerAI] Respuesta recibida: " + data.Substring(0, Math.Min(200, data.Length())));
+		// El servicio ya tiene este estado: sirve como base delta
+		m_Delta.Acknowledge(tick);
+		m_EventDispatcher.Acknowledge(tick);
+
+		ApplyResponse(tick, data);
+	}
+
+	// -------------------------------------------------------
+	// El scheduler dio por perdida la petición: reenviar sus eventos y
+	// entidades en el próximo tick
+	void OnRequestExpired(int tick)
+	{
+		DiscardTick(tick);
+	}
+
+	// -------------------------------------------------------
+	private void DiscardTick(int tick)
+	{
+		m_Delta.Discard(tick);
+		m_EventDispatcher.Discard(tick);
+	}
+
+	// -------------------------------------------------------
+	void OnResultResponse(int tick, int code, string data)
+	{
+		if (code != 200)
+		{
+			m_Scheduler.Finish(tick);
+			if (m_Config.m_bDebugMode)
+				Print("[ReforgerAI] Error HTTP " + code + " recogiendo resultado");
+			return;
+		}
 
-		m_CommandReceiver.ProcessCommandJson(data);
+		ApplyResponse(tick, data);
 	}
 
 	// -------------------------------------------------------
-	// Helpers
-	private string GetEntityFaction(IEntity ent)
+	// Aplicar una respuesta (o parte) y, si el servicio indica que quedan
+	// comandos por generar, pedir el resto con GET /result/<id>.
+	private void ApplyResponse(int tick, string data)
 	{
-		FactionAffiliationComponent fac = FactionAffiliationComponent.Cast(
-			ent.FindComponent(FactionAffiliationComponent));
-		if (!fac) return "UNKNOWN";
-		Faction f = fac.GetAffiliatedFaction();
-		if (!f) return "UNKNOWN";
-		return f.GetFactionKey();
+		// Descartar respuestas más antiguas que la última aplicada
+		if (!m_Scheduler.Accept(tick))
+		{
+			m_Scheduler.Finish(tick);
+			return;
+		}
+
+		if (m_Config.m_bDebugMode)
+			Print("[ReforgerAI] Respuesta recibida: " + data.Substring(0, Math.Min(200, data.Length())));
+
+		string resultId;
+		if (!m_CommandReceiver.ProcessCommandJson(data, tick, resultId) || resultId == "")
+		{
+			m_Scheduler.Finish(tick);
+			return;
+		}
+
+		GetGame().GetCallqueue().CallLater(PollResult, m_Config.m_iResultPollDelay, false, tick, resultId);
 	}
 
-	private float GetEntityHealth(IEntity ent)
+	// -------------------------------------------------------
+	// GET /result/<id>: el servicio mantiene la petición abierta hasta
+	// tener comandos nuevos o terminar
+	void PollResult(int tick, string resultId)
 	{
-		SCR_CharacterDamageManagerComponent dmg = SCR_CharacterDamageManagerComponent.Cast(
-			ent.FindComponent(SCR_CharacterDamageManagerComponent));
-		if (!dmg) return 100.0;
-		return dmg.GetHealthScaled() * 100.0;
+		// La petición expiró o se cerró mientras esperábamos
+		AIPendingRequest req = m_Scheduler.Get(tick);
+		if (!req) return;
+
+		RestContext ctx = GetGame().GetRestApi().GetContext(m_Config.m_sServiceURL);
+		RestCallback cb = new RestCallback();
+		cb.m_Callback = req.OnResultResponse;
+		req.Attach(cb);
+		ctx.GET(cb, "/result/" + resultId);
 	}
 
-	private bool IsInVehicle(IEntity ent)
+	// -------------------------------------------------------
+	// Sin comandos pendientes ni envíos urgentes: momento para trabajo de fondo
+	bool IsQuiet()
 	{
-		CompartmentAccessComponent comp = CompartmentAccessComponent.Cast(
-			ent.FindComponent(CompartmentAccessComponent));
-		return comp && comp.IsInCompartment();
+		return m_CommandReceiver.GetQueueDepth() == 0
+			&& m_ePendingUrgency == EAIEventUrgency.ROUTINE;
 	}
 
 	// -------------------------------------------------------
@@ -3,30 +3,91 @@
 // ReforgerAI Mod v1.0.0
 // ============================================================
 
+// Comando pendiente de ejecutar en un frame posterior
+class AIQueuedCommand
+{
+	string type;
+	string target;
+	ref JsonLoadContext params;
+	ref JsonLoadContext root; // Mantiene viva la respuesta de la que cuelga params
+	int cost;
+	int tick; // Tick de la respuesta que lo generó
+
+	// Solo para grupos de refuerzo ya expandidos
+	string faction;
+	vector position;
+}
+
 class AICommandReceiver
 {
 	private AIBridge m_Bridge;
 	private ref AIGroupController m_GroupCtrl;
 	private ref AIMissionManager m_MissionMgr;
 
+	private ref array<ref AIQueuedCommand> m_Queue;
+	private int m_iQueueHead;
+	private int m_iQueueTick; // Tick de la respuesta más reciente encolada
+	private int m_iMaxDepth;
+	private int m_iLastFrameCost;
+	private int m_iExecuted;
+	private int m_iDropped;
+	private int m_iSuperseded;
+	private int m_iBusyFrames;
+	private int m_iTotalCost;
+
+	// Tope de comandos encolados; los que lleguen después se descartan
+	static const int MAX_QUEUE = 128;
+	// Tope de grupos por CALL_REINFORCEMENTS
+	static const int MAX_REINFORCEMENT_GROUPS = 4;
+
+	// Tipo interno: un grupo de CALL_REINFORCEMENTS ya expandido
+	static const string REINFORCEMENT_GROUP = "_REINFORCEMENT_GROUP";
+
 	// -------------------------------------------------------
 	void AICommandReceiver(AIBridge bridge)
 	{
 		m_Bridge = bridge;
 		m_GroupCtrl = AIGroupController.GetInstance();
 		m_MissionMgr = AIMissionManager.GetInstance();
+		m_Queue = new array<ref AIQueuedCommand>();
+	}
+
+	// -------------------------------------------------------
+	// Coste relativo de cada comando para el presupuesto por frame
+	static int GetCommandCost(string type)
+	{
+		switch (type)
+		{
+			case "SPAWN_GROUP":
+			case REINFORCEMENT_GROUP:
+				return 8;
+			case "DESPAWN_GROUP":
+				return 4;
+			case "SET_WAYPOINT":
+			case "SET_AMBUSH":
+				return 2;
+		}
+		return 1;
 	}
 
 	// -------------------------------------------------------
-	void ProcessCommandJson(string jsonStr)
+	// Encola los comandos de la respuesta del tick. Devuelve true si el
+	// servicio sigue generando comandos que se recogen con resultId.
+	bool ProcessCommandJson(string jsonStr, int tick, out string resultId)
 	{
+		resultId = "";
 		JsonLoadContext json = new JsonLoadContext();
 		if (!json.LoadFromString(jsonStr))
 		{
 			Print("[ReforgerAI] JSON inválido en respuesta IA");
-			return;
+			return false;
 		}
 
+		bool more;
+		json.ReadBool("more", more);
+		if (more)
+			json.ReadString("result_id", resultId);
+
 		string cmdId, reasoning;
 		json.ReadString("command_id", cmdId);
 		json.ReadString("reasoning", reasoning);
@@ -36,26 +97,164 @@ class AICommandReceiver
 
 		// Iterar array de comandos
 		JsonLoadContext cmdsArray;
-		if (!json.ReadObject("commands", cmdsArray)) return;
+		if (!json.ReadObject("commands", cmdsArray)) return more;
 
+		// Una respuesta más reciente con órdenes sustituye a lo que quede de
+		// las anteriores (las respuestas vacías de "sin cambios" no)
 		int cmdCount = cmdsArray.GetArraySize();
+		if (cmdCount > 0 && tick > m_iQueueTick)
+		{
+			DropOlderThan(tick);
+			m_iQueueTick = tick;
+		}
+
+		// Los comandos se encolan y se ejecutan repartidos entre frames
 		for (int i = 0; i < cmdCount; i++)
 		{
 			JsonLoadContext cmd;
 			cmdsArray.ReadArrayElement(i, cmd);
-			ExecuteCommand(cmd);
+			EnqueueCommand(json, cmd, tick);
+		}
+		return more;
+	}
+
+	// -------------------------------------------------------
+	// Ejecutar comandos encolados hasta agotar el presupuesto del frame.
+	// Siempre se ejecuta al menos uno para garantizar progreso.
+	void ProcessQueue()
+	{
+		m_iLastFrameCost = 0;
+		if (m_iQueueHead >= m_Queue.Count()) return;
+
+		AIBridgeConfig cfg = m_Bridge.m_Config;
+		int start = System.GetTickCount();
+
+		while (m_iQueueHead < m_Queue.Count())
+		{
+			AIQueuedCommand qc = m_Queue[m_iQueueHead];
+			if (m_iLastFrameCost > 0)
+			{
+				if (m_iLastFrameCost + qc.cost > cfg.m_iCommandBudgetPerFrame) break;
+				if (System.GetTickCount() - start >= cfg.m_fCommandTimeBudgetMs) break;
+			}
+
+			m_Queue[m_iQueueHead] = null;
+			m_iQueueHead++;
+			ExecuteCommand(qc);
+			m_iLastFrameCost += qc.cost;
+			m_iExecuted++;
 		}
+
+		// Cola vacía: reiniciar sin desplazar elementos. Con carga sostenida
+		// se compacta al consumir la mitad para no acumular huecos.
+		if (m_iQueueHead >= m_Queue.Count())
+		{
+			m_Queue.Clear();
+			m_iQueueHead = 0;
+		}
+		else if (m_iQueueHead * 2 >= m_Queue.Count())
+		{
+			CompactQueue();
+		}
+
+		m_iBusyFrames++;
+		m_iTotalCost += m_iLastFrameCost;
 	}
 
 	// -------------------------------------------------------
-	private void ExecuteCommand(JsonLoadContext cmd)
+	int GetQueueDepth()
 	{
-		string type, target;
-		cmd.ReadString("type", type);
-		cmd.ReadString("target", target);
+		return m_Queue.Count() - m_iQueueHead;
+	}
 
-		JsonLoadContext params;
-		cmd.ReadObject("params", params);
+	// -------------------------------------------------------
+	void SerializeStats(JsonWriteContext json)
+	{
+		json.WriteObjectBegin();
+		json.WriteInt("depth", GetQueueDepth());
+		json.WriteInt("max_depth", m_iMaxDepth);
+		json.WriteInt("last_frame_cost", m_iLastFrameCost);
+		if (m_iBusyFrames > 0)
+		{
+			float totalCost = m_iTotalCost;
+			json.WriteFloat("avg_frame_cost", totalCost / m_iBusyFrames);
+		}
+		json.WriteInt("executed", m_iExecuted);
+		json.WriteInt("dropped", m_iDropped);
+		json.WriteInt("superseded", m_iSuperseded);
+		json.WriteObjectEnd();
+	}
+
+	// -------------------------------------------------------
+	private void EnqueueCommand(JsonLoadContext root, JsonLoadContext cmd, int tick)
+	{
+		AIQueuedCommand qc = new AIQueuedCommand();
+		qc.root = root;
+		qc.tick = tick;
+		cmd.ReadString("type", qc.type);
+		cmd.ReadString("target", qc.target);
+		cmd.ReadObject("params", qc.params);
+
+		// Cada grupo de refuerzo es un spawn independiente en la cola
+		if (qc.type == "CALL_REINFORCEMENTS")
+		{
+			ExpandReinforcements(qc.params, tick);
+			return;
+		}
+
+		qc.cost = GetCommandCost(qc.type);
+		PushQueued(qc);
+	}
+
+	// -------------------------------------------------------
+	private void PushQueued(AIQueuedCommand qc)
+	{
+		if (GetQueueDepth() >= MAX_QUEUE)
+		{
+			m_iDropped++;
+			return;
+		}
+
+		m_Queue.Insert(qc);
+		m_iMaxDepth = Math.Max(m_iMaxDepth, GetQueueDepth());
+	}
+
+	// -------------------------------------------------------
+	// Mover los comandos pendientes al principio del array
+	private void CompactQueue()
+	{
+		array<ref AIQueuedCommand> pending = new array<ref AIQueuedCommand>();
+		for (int i = m_iQueueHead; i < m_Queue.Count(); i++)
+			pending.Insert(m_Queue[i]);
+
+		m_Queue = pending;
+		m_iQueueHead = 0;
+	}
+
+	// -------------------------------------------------------
+	// Descartar los comandos pendientes de respuestas anteriores al tick
+	private void DropOlderThan(int tick)
+	{
+		array<ref AIQueuedCommand> pending = new array<ref AIQueuedCommand>();
+		for (int i = m_iQueueHead; i < m_Queue.Count(); i++)
+		{
+			AIQueuedCommand qc = m_Queue[i];
+			if (qc.tick < tick)
+				m_iSuperseded++;
+			else
+				pending.Insert(qc);
+		}
+
+		m_Queue = pending;
+		m_iQueueHead = 0;
+	}
+
+	// -------------------------------------------------------
+	private void ExecuteCommand(AIQueuedCommand qc)
+	{
+		string type = qc.type;
+		string target = qc.target;
+		JsonLoadContext params = qc.params;
 
 		switch (type)
 		{
@@ -83,8 +282,8 @@ class AICommandReceiver
 			case "END_MISSION":
 				ExecEndMission(target);
 				break;
-			case "CALL_REINFORCEMENTS":
-				ExecCallReinforcements(params);
+			case REINFORCEMENT_GROUP:
+				m_GroupCtrl.SpawnGroup(qc.faction, "infantry_squad", qc.position);
 				break;
 			case "SET_AMBUSH":
 				ExecSetAmbush(target, params);
@@ -124,7 +323,7 @@ class AICommandReceiver
 		vector pos = ReadPosition(params);
 		string behavior;
 		params.ReadString("behavior", behavior);
-		m_GroupCtrl.SetWaypointWithBehavior(group, pos, behavior);
+		m_GroupCtrl.SetWaypointWithBehavior(groupId, pos, behavior);
 	}
 
 	// -------------------------------------------------------
@@ -179,20 +378,25 @@ class AICommandReceiver
 	}
 
 	// -------------------------------------------------------
-	private void ExecCallReinforcements(JsonLoadContext params)
+	private void ExpandReinforcements(JsonLoadContext params, int tick)
 	{
 		vector pos = ReadPosition(params);
 		string faction;
 		params.ReadString("faction", faction);
 		int count;
 		params.ReadInt("group_count", count);
-		if (count <= 0) count = 1;
+		count = Math.ClampInt(count, 1, MAX_REINFORCEMENT_GROUPS);
 
 		for (int i = 0; i < count; i++)
 		{
-			vector spawnPos = pos + Vector(
+			AIQueuedCommand qc = new AIQueuedCommand();
+			qc.type = REINFORCEMENT_GROUP;
+			qc.tick = tick;
+			qc.faction = faction;
+			qc.position = pos + Vector(
 				Math.RandomFloat(-100, 100), 0, Math.RandomFloat(-100, 100));
-			m_GroupCtrl.SpawnGroup(faction, "infantry_squad", spawnPos);
+			qc.cost = GetCommandCost(qc.type);
+			PushQueued(qc);
 		}
 	}
 
@@ -203,7 +407,7 @@ class AICommandReceiver
 		if (!group) return;
 
 		vector pos = ReadPosition(params);
-		m_GroupCtrl.SetAmbushPosition(group, pos);
+		m_GroupCtrl.SetAmbushPosition(groupId, pos);
 	}
 
 	// -------------------------------------------------------
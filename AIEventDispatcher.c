@@ -15,13 +15,104 @@ enum EAIEventType
 	REINFORCEMENT_ARRIVED
 }
 
+// Cada prioridad tiene su propio buffer: el spam de baja prioridad
+// nunca desplaza eventos críticos.
+enum EAIEventPriority
+{
+	LOW,
+	NORMAL,
+	CRITICAL
+}
+
+// Cuánto debe adelantarse el próximo envío de estado al llegar el evento
+enum EAIEventUrgency
+{
+	ROUTINE,   // Esperar al tick normal
+	ELEVATED,  // No esperar más que el intervalo base
+	IMMEDIATE  // Enviar en cuanto haya hueco
+}
+
+// -------------------------------------------------------
+// Payloads tipados de eventos (se serializan en "data")
+class AIEventData
+{
+	void Serialize(JsonWriteContext json)
+	{
+	}
+
+	protected void WritePosition(JsonWriteContext json, string key, vector pos)
+	{
+		json.WriteKey(key);
+		json.WriteObjectBegin();
+		json.WriteFloat("x", pos[0]);
+		json.WriteFloat("y", pos[1]);
+		json.WriteFloat("z", pos[2]);
+		json.WriteObjectEnd();
+	}
+}
+
+class AIContactEventData : AIEventData
+{
+	vector enemyPos;
+	int enemyCount;
+	float distance;
+
+	override void Serialize(JsonWriteContext json)
+	{
+		WritePosition(json, "enemy_position", enemyPos);
+		json.WriteInt("enemy_count", enemyCount);
+		json.WriteFloat("distance", distance);
+	}
+}
+
+class AIUnitKilledEventData : AIEventData
+{
+	string unitId;
+
+	override void Serialize(JsonWriteContext json)
+	{
+		json.WriteString("unit_id", unitId);
+	}
+}
+
+class AIPlayerDownedEventData : AIEventData
+{
+	string playerId;
+	vector position;
+	bool hasPosition;
+
+	override void Serialize(JsonWriteContext json)
+	{
+		json.WriteString("player_id", playerId);
+		if (hasPosition)
+			WritePosition(json, "position", position);
+	}
+}
+
+class AIObjectiveEventData : AIEventData
+{
+	string objectiveId;
+	string faction;
+	vector position;
+
+	override void Serialize(JsonWriteContext json)
+	{
+		json.WriteString("objective_id", objectiveId);
+		json.WriteString("faction", faction);
+		WritePosition(json, "position", position);
+	}
+}
+
 class AIEvent
 {
 	string eventId;
 	string type;
 	float timestamp;
 	string sourceGroup;
-	ref JsonWriteContext dataJson;
+	ref AIEventData data;
+	int count;          // Eventos fusionados en este
+	float lastTimestamp;
+	int seq;            // Orden de inserción en su buffer
 
 	void AIEvent(string t, string src)
 	{
@@ -29,23 +120,168 @@ class AIEvent
 		eventId = "evt_" + (counter++).ToString().PadLeft(4, "0");
 		type = t;
 		timestamp = System.GetTickCount() / 1000.0;
+		lastTimestamp = timestamp;
 		sourceGroup = src;
-		dataJson = new JsonWriteContext();
+		count = 1;
+	}
+}
+
+// Buffer circular de capacidad fija: insertar es O(1) y, lleno,
+// sobrescribe el evento más antiguo.
+class AIEventRing
+{
+	private ref array<ref AIEvent> m_Slots;
+	private int m_iCapacity;
+	private int m_iHead;
+	private int m_iCount;
+	private int m_iNextSeq;
+
+	void AIEventRing(int capacity)
+	{
+		m_iCapacity = capacity;
+		m_Slots = new array<ref AIEvent>();
+		m_Slots.Resize(capacity);
+	}
+
+	// Devuelve true si se ha descartado el evento más antiguo
+	bool Push(AIEvent evt)
+	{
+		evt.seq = m_iNextSeq++;
+		m_Slots[(m_iHead + m_iCount) % m_iCapacity] = evt;
+
+		if (m_iCount < m_iCapacity)
+		{
+			m_iCount++;
+			return false;
+		}
+
+		m_iHead = (m_iHead + 1) % m_iCapacity;
+		return true;
+	}
+
+	// ¿Sigue el evento dentro del buffer?
+	bool Holds(AIEvent evt)
+	{
+		return evt.seq >= m_iNextSeq - m_iCount;
+	}
+
+	int Count()
+	{
+		return m_iCount;
+	}
+
+	// i = 0 es el más antiguo
+	AIEvent Get(int i)
+	{
+		return m_Slots[(m_iHead + i) % m_iCapacity];
+	}
+
+	void Clear()
+	{
+		for (int i = 0; i < m_iCapacity; i++)
+			m_Slots[i] = null;
+		m_iHead = 0;
+		m_iCount = 0;
+	}
+
+	// Volver a encolar eventos no entregados por delante de los actuales.
+	// Devuelve cuántos se descartan por falta de espacio.
+	int Requeue(array<ref AIEvent> older)
+	{
+		array<ref AIEvent> newer = new array<ref AIEvent>();
+		for (int i = 0; i < m_iCount; i++)
+			newer.Insert(Get(i));
+		Clear();
+
+		int dropped = 0;
+		foreach (AIEvent evt : older)
+		{
+			if (Push(evt)) dropped++;
+		}
+		foreach (AIEvent evt : newer)
+		{
+			if (Push(evt)) dropped++;
+		}
+		return dropped;
+	}
+}
+
+// Eventos y contadores enviados en un tick, pendientes de que el servicio
+// confirme la petición
+class AIEventBatch
+{
+	ref array<ref AIEvent> m_Events;
+	int m_iDropped;
+	int m_iMerged;
+
+	void AIEventBatch()
+	{
+		m_Events = new array<ref AIEvent>();
 	}
 }
 
 class AIEventDispatcher
 {
 	private AIBridge m_Bridge;
-	private ref array<ref AIEvent> m_PendingEvents;
+	private ref array<ref AIEventRing> m_Rings; // indexado por EAIEventPriority
+	private ref map<string, ref AIEvent> m_ContactIndex; // grupo → último contacto
+	private ref map<int, ref AIEventBatch> m_Unacked;    // tick → eventos enviados
+	private int m_iDropped;
+	private int m_iMerged;
+
+	static const int RING_CAPACITY_LOW = 16;
+	static const int RING_CAPACITY_NORMAL = 32;
+	static const int RING_CAPACITY_CRITICAL = 32;
+	// Lotes sin confirmar que se conservan como máximo
+	static const int MAX_UNACKED = 16;
 
 	void AIEventDispatcher(AIBridge bridge)
 	{
 		m_Bridge = bridge;
-		m_PendingEvents = new array<ref AIEvent>();
+		m_Rings = new array<ref AIEventRing>();
+		m_Rings.Insert(new AIEventRing(RING_CAPACITY_LOW));
+		m_Rings.Insert(new AIEventRing(RING_CAPACITY_NORMAL));
+		m_Rings.Insert(new AIEventRing(RING_CAPACITY_CRITICAL));
+		m_ContactIndex = new map<string, ref AIEvent>();
+		m_Unacked = new map<int, ref AIEventBatch>();
 		RegisterCallbacks();
 	}
 
+	// -------------------------------------------------------
+	static EAIEventPriority GetPriority(string type)
+	{
+		switch (type)
+		{
+			case "UNIT_KILLED":
+			case "PLAYER_DOWNED":
+			case "OBJECTIVE_CAPTURED":
+			case "VEHICLE_DESTROYED":
+			case "MISSION_COMPLETED":
+			case "MISSION_FAILED":
+				return EAIEventPriority.CRITICAL;
+			case "REINFORCEMENT_ARRIVED":
+				return EAIEventPriority.NORMAL;
+		}
+		return EAIEventPriority.LOW;
+	}
+
+	// -------------------------------------------------------
+	static EAIEventUrgency GetUrgency(string type)
+	{
+		switch (type)
+		{
+			case "PLAYER_DOWNED":
+			case "OBJECTIVE_CAPTURED":
+			case "MISSION_FAILED":
+				return EAIEventUrgency.IMMEDIATE;
+			case "UNIT_KILLED":
+			case "VEHICLE_DESTROYED":
+			case "MISSION_COMPLETED":
+				return EAIEventUrgency.ELEVATED;
+		}
+		return EAIEventUrgency.ROUTINE;
+	}
+
 	// -------------------------------------------------------
 	private void RegisterCallbacks()
 	{
@@ -63,43 +299,192 @@ class AIEventDispatcher
 	// -------------------------------------------------------
 	void PushEvent(AIEvent evt)
 	{
-		m_PendingEvents.Insert(evt);
-		if (m_PendingEvents.Count() > 50)
-			m_PendingEvents.RemoveIndex(0); // Evitar overflow
+		if (m_Rings[GetPriority(evt.type)].Push(evt))
+			m_iDropped++; // Buffer lleno: se pierde el más antiguo de su prioridad
+
+		EAIEventUrgency urgency = GetUrgency(evt.type);
+		if (urgency != EAIEventUrgency.ROUTINE)
+			m_Bridge.RequestEarlySend(urgency);
+	}
+
+	// -------------------------------------------------------
+	// Escribe los eventos pendientes, de mayor a menor prioridad. Quedan
+	// retenidos con el tick hasta que el servicio confirme la petición.
+	void FlushEvents(JsonWriteContext json, int tick)
+	{
+		AIEventBatch batch = new AIEventBatch();
+		batch.m_iDropped = m_iDropped;
+		batch.m_iMerged = m_iMerged;
+		m_iDropped = 0;
+		m_iMerged = 0;
+
+		for (int p = EAIEventPriority.CRITICAL; p >= EAIEventPriority.LOW; p--)
+		{
+			AIEventRing ring = m_Rings[p];
+			for (int i = 0; i < ring.Count(); i++)
+			{
+				AIEvent evt = ring.Get(i);
+				batch.m_Events.Insert(evt);
+				json.WriteObjectBegin();
+				json.WriteString("event_id", evt.eventId);
+				json.WriteString("type", evt.type);
+				json.WriteFloat("timestamp", evt.timestamp);
+				json.WriteString("source_group", evt.sourceGroup);
+				if (evt.count > 1)
+				{
+					json.WriteInt("count", evt.count);
+					json.WriteFloat("last_timestamp", evt.lastTimestamp);
+				}
+				if (evt.data)
+				{
+					json.WriteKey("data");
+					json.WriteObjectBegin();
+					evt.data.Serialize(json);
+					json.WriteObjectEnd();
+				}
+				json.WriteObjectEnd();
+			}
+			ring.Clear();
+		}
+		m_ContactIndex.Clear();
+
+		m_Unacked.Set(tick, batch);
+		if (m_Unacked.Count() > MAX_UNACKED)
+		{
+			// Petición que nunca respondió: sus eventos se dan por perdidos
+			int oldest = tick;
+			foreach (int t, AIEventBatch b : m_Unacked)
+			{
+				if (t < oldest) oldest = t;
+			}
+			m_iDropped += m_Unacked.Get(oldest).m_Events.Count();
+			m_Unacked.Remove(oldest);
+		}
+	}
+
+	// -------------------------------------------------------
+	// Eventos descartados/fusionados que viajan en el tick
+	void SerializeStats(JsonWriteContext json, int tick)
+	{
+		AIEventBatch batch = m_Unacked.Get(tick);
+		json.WriteObjectBegin();
+		json.WriteInt("dropped", batch ? batch.m_iDropped : 0);
+		json.WriteInt("merged", batch ? batch.m_iMerged : 0);
+		json.WriteObjectEnd();
 	}
 
 	// -------------------------------------------------------
-	void FlushEvents(JsonWriteContext json)
+	// El servicio ha recibido el tick: sus eventos ya están entregados
+	void Acknowledge(int tick)
 	{
-		foreach (AIEvent evt : m_PendingEvents)
+		m_Unacked.Remove(tick);
+	}
+
+	// -------------------------------------------------------
+	// La petición falló: devolver sus eventos y contadores a la cola
+	void Discard(int tick)
+	{
+		AIEventBatch batch = m_Unacked.Get(tick);
+		if (!batch) return;
+
+		m_iDropped += batch.m_iDropped;
+		m_iMerged += batch.m_iMerged;
+
+		// Los eventos urgentes reintentan el envío sin esperar al tick normal
+		EAIEventUrgency urgency = EAIEventUrgency.ROUTINE;
+		foreach (AIEvent pending : batch.m_Events)
+		{
+			EAIEventUrgency u = GetUrgency(pending.type);
+			if (u > urgency)
+				urgency = u;
+		}
+		if (urgency != EAIEventUrgency.ROUTINE)
+			m_Bridge.RequestEarlySend(urgency);
+
+		for (int p = EAIEventPriority.LOW; p <= EAIEventPriority.CRITICAL; p++)
 		{
-			json.WriteObjectBegin();
-			json.WriteString("event_id", evt.eventId);
-			json.WriteString("type", evt.type);
-			json.WriteFloat("timestamp", evt.timestamp);
-			json.WriteString("source_group", evt.sourceGroup);
-			json.WriteObjectEnd();
+			array<ref AIEvent> older = new array<ref AIEvent>();
+			foreach (AIEvent evt : batch.m_Events)
+			{
+				if (GetPriority(evt.type) == p)
+					older.Insert(evt);
+			}
+			if (!older.IsEmpty())
+				m_iDropped += m_Rings[p].Requeue(older);
 		}
-		m_PendingEvents.Clear();
+		m_Unacked.Remove(tick);
 	}
 
 	// -------------------------------------------------------
 	// API pública para que otros componentes registren eventos
 	void OnContactSpotted(string groupId, vector enemyPos, int enemyCount, float distance)
 	{
+		// Fusionar contactos repetidos del mismo grupo dentro de la ventana
+		float now = System.GetTickCount() / 1000.0;
+		AIEvent prev = m_ContactIndex.Get(groupId);
+		if (prev && m_Rings[EAIEventPriority.LOW].Holds(prev)
+			&& now - prev.lastTimestamp <= m_Bridge.m_Config.m_fContactCoalesceWindow)
+		{
+			// Se conserva el último avistamiento
+			AIContactEventData prevData = AIContactEventData.Cast(prev.data);
+			prevData.enemyPos = enemyPos;
+			prevData.enemyCount = enemyCount;
+			prevData.distance = distance;
+			prev.count++;
+			prev.lastTimestamp = now;
+			m_iMerged++;
+			return;
+		}
+
+		AIContactEventData data = new AIContactEventData();
+		data.enemyPos = enemyPos;
+		data.enemyCount = enemyCount;
+		data.distance = distance;
+
 		AIEvent evt = new AIEvent("CONTACT_SPOTTED", groupId);
+		evt.data = data;
+		m_ContactIndex.Set(groupId, evt);
 		PushEvent(evt);
 	}
 
 	void OnUnitKilled(string groupId, string unitId)
 	{
+		AIGroupController.GetInstance().MarkGroupDirty(groupId);
+
+		AIUnitKilledEventData data = new AIUnitKilledEventData();
+		data.unitId = unitId;
+
 		AIEvent evt = new AIEvent("UNIT_KILLED", groupId);
+		evt.data = data;
 		PushEvent(evt);
 	}
 
 	void OnPlayerDowned(int playerId)
 	{
+		AIPlayerDownedEventData data = new AIPlayerDownedEventData();
+		data.playerId = "player_" + playerId.ToString();
+
+		IEntity ent = GetGame().GetPlayerManager().GetPlayerControlledEntity(playerId);
+		if (ent)
+		{
+			data.position = ent.GetOrigin();
+			data.hasPosition = true;
+		}
+
 		AIEvent evt = new AIEvent("PLAYER_DOWNED", "");
+		evt.data = data;
+		PushEvent(evt);
+	}
+
+	void OnObjectiveCaptured(string objectiveId, string faction, vector pos)
+	{
+		AIObjectiveEventData data = new AIObjectiveEventData();
+		data.objectiveId = objectiveId;
+		data.faction = faction;
+		data.position = pos;
+
+		AIEvent evt = new AIEvent("OBJECTIVE_CAPTURED", "");
+		evt.data = data;
 		PushEvent(evt);
 	}
 }
@@ -14,9 +14,9 @@ class AIGameMasterHelper
 
 	// -------------------------------------------------------
 	// Serializar misiones activas (delega a AIMissionManager)
-	void SerializeActiveMissions(JsonWriteContext json)
+	void SerializeActiveMissions(JsonWriteContext json, AIStateDelta delta = null)
 	{
-		AIMissionManager.GetInstance().SerializeActiveMissions(json);
+		AIMissionManager.GetInstance().SerializeActiveMissions(json, delta);
 	}
 
 	// -------------------------------------------------------
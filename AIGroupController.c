@@ -3,11 +3,118 @@
 // ReforgerAI Mod v1.0.0
 // ============================================================
 
+// Datos serializados de un grupo, válidos hasta que se marque sucio
+class AIGroupCacheEntry
+{
+	string m_sFaction;
+	int m_iUnitCount;
+	bool m_bHasLeader;
+	vector m_vLeaderPos; // origen del líder en el último recálculo
+	vector m_vLivePos;   // origen del líder en la serialización actual
+	float m_fHealthAvg;
+	bool m_bDirty;
+	float m_fUpdatedAt; // ms
+	ref AIGroupCacheListener m_Listener;
+
+	void AIGroupCacheEntry()
+	{
+		m_bDirty = true;
+	}
+}
+
+// Recibe eventos de miembros/daño de un grupo y lo marca sucio
+class AIGroupCacheListener
+{
+	string m_sGroupId;
+	private ref set<SCR_CharacterDamageManagerComponent> m_HookedDamage;
+
+	void AIGroupCacheListener(string groupId)
+	{
+		m_sGroupId = groupId;
+		m_HookedDamage = new set<SCR_CharacterDamageManagerComponent>();
+	}
+
+	// Suscribirse una sola vez al daño de cada soldado
+	void HookDamage(SCR_CharacterDamageManagerComponent dmg)
+	{
+		if (!dmg || m_HookedDamage.Contains(dmg)) return;
+		m_HookedDamage.Insert(dmg);
+		dmg.GetOnDamageStateChanged().Insert(OnDamageStateChanged);
+		dmg.GetOnDamage().Insert(OnDamage);
+	}
+
+	void HookGroup(AIGroup group)
+	{
+		SCR_AIGroup scrGroup = SCR_AIGroup.Cast(group);
+		if (!scrGroup) return;
+		scrGroup.GetOnAgentAdded().Insert(OnMembershipChanged);
+		scrGroup.GetOnAgentRemoved().Insert(OnMembershipChanged);
+	}
+
+	// Quitar todas las suscripciones antes de eliminar el grupo
+	void Unhook(AIGroup group)
+	{
+		foreach (SCR_CharacterDamageManagerComponent dmg : m_HookedDamage)
+		{
+			if (!dmg) continue;
+			dmg.GetOnDamageStateChanged().Remove(OnDamageStateChanged);
+			dmg.GetOnDamage().Remove(OnDamage);
+		}
+		m_HookedDamage.Clear();
+
+		SCR_AIGroup scrGroup = SCR_AIGroup.Cast(group);
+		if (!scrGroup) return;
+		scrGroup.GetOnAgentAdded().Remove(OnMembershipChanged);
+		scrGroup.GetOnAgentRemoved().Remove(OnMembershipChanged);
+	}
+
+	void OnMembershipChanged(AIAgent agent)
+	{
+		AIGroupController.GetInstance().MarkGroupDirty(m_sGroupId);
+	}
+
+	void OnDamageStateChanged(EDamageState state)
+	{
+		AIGroupController.GetInstance().MarkGroupDirty(m_sGroupId);
+	}
+
+	// Cualquier daño cambia health_avg, no solo los cambios de EDamageState
+	void OnDamage(BaseDamageContext damageContext)
+	{
+		AIGroupController.GetInstance().MarkGroupDirty(m_sGroupId);
+	}
+}
+
 class AIGroupController
 {
 	private static AIGroupController s_Instance;
 	private ref map<string, AIGroup> m_Groups;
+	private ref map<string, ref AIGroupCacheEntry> m_GroupCache;
 	private int m_iGroupCounter;
+	private int m_iCacheHits;
+	private int m_iCacheMisses;
+
+	private ref map<string, string> m_TemplatePrefabs;    // "FACCIÓN:plantilla" → prefab
+	private ref map<string, ref Resource> m_PrefabCache; // prefab → recurso cargado
+	private ref array<AIWaypoint> m_FreeWaypoints;
+	private ref map<string, AIWaypoint> m_ActiveWaypoints; // id de grupo → waypoint
+	private int m_iWaypointsSpawned;
+	private int m_iWaypointsReused;
+
+	private AIBridgeConfig m_PoolConfig;
+	private ref map<string, ref array<AIGroup>> m_WarmGroups; // "FACCIÓN:plantilla" → grupos ocultos
+	private ref array<AIGroup> m_HidingGroups; // recién creados, a la espera de sus miembros
+	private int m_iPoolHits;
+	private int m_iPoolMisses;
+
+	static const string WAYPOINT_PREFAB = "{E2957DCB8B2F14F9}Prefabs/AI/Waypoints/AIWaypoint.et";
+	// Waypoints libres que se conservan para reutilizar; el resto se borra
+	static const int MAX_FREE_WAYPOINTS = 64;
+
+	// Distancia que puede moverse el líder sin recalcular el grupo (m)
+	static const float CACHE_MOVE_THRESHOLD = 10.0;
+	// Antigüedad máxima de una entrada aunque no se marque sucia (ms)
+	static const float CACHE_MAX_AGE_MS = 10000;
 
 	static AIGroupController GetInstance()
 	{
@@ -18,7 +125,31 @@ class AIGroupController
 	void AIGroupController()
 	{
 		m_Groups = new map<string, AIGroup>();
+		m_GroupCache = new map<string, ref AIGroupCacheEntry>();
 		m_iGroupCounter = 0;
+
+		m_PrefabCache = new map<string, ref Resource>();
+		m_FreeWaypoints = new array<AIWaypoint>();
+		m_ActiveWaypoints = new map<string, AIWaypoint>();
+		m_WarmGroups = new map<string, ref array<AIGroup>>();
+		m_HidingGroups = new array<AIGroup>();
+
+		// Mapa de plantillas — ajusta con los prefabs de tu servidor
+		m_TemplatePrefabs = new map<string, string>();
+		m_TemplatePrefabs.Set("OPFOR:infantry_squad", "{B5DF06B6DCA0D870}Prefabs/Groups/OPFOR/Group_OPFOR_Rifle_Squad.et");
+		m_TemplatePrefabs.Set("BLUFOR:infantry_squad", "{A8476E3F6B2B7541}Prefabs/Groups/FIA/Group_FIA_Rifle_Squad.et");
+	}
+
+	// -------------------------------------------------------
+	// Cargar de antemano todos los prefabs de waypoints y grupos
+	void PreloadPrefabs()
+	{
+		GetPrefab(WAYPOINT_PREFAB);
+		foreach (string key, string path : m_TemplatePrefabs)
+		{
+			GetPrefab(path);
+		}
+		Print("[ReforgerAI] Prefabs precargados: " + m_PrefabCache.Count());
 	}
 
 	// -------------------------------------------------------
@@ -28,6 +159,15 @@ class AIGroupController
 		if (id == "")
 			id = "grp_" + (m_iGroupCounter++).ToString().PadLeft(3, "0");
 		m_Groups.Set(id, group);
+		CreateCacheEntry(id, group);
+	}
+
+	// -------------------------------------------------------
+	// Forzar recálculo del grupo en la próxima serialización
+	void MarkGroupDirty(string id)
+	{
+		AIGroupCacheEntry entry = m_GroupCache.Get(id);
+		if (entry) entry.m_bDirty = true;
 	}
 
 	AIGroup GetGroup(string id)
@@ -59,15 +199,15 @@ class AIGroupController
 	}
 
 	// -------------------------------------------------------
-	void SetWaypointWithBehavior(AIGroup group, vector position, string behavior)
+	void SetWaypointWithBehavior(string groupId, vector position, string behavior)
 	{
+		AIGroup group = m_Groups.Get(groupId);
 		if (!group) return;
 
-		AIWaypoint wp = AIWaypoint.Cast(
-			GetGame().SpawnEntityPrefab(
-				Resource.Load("{E2957DCB8B2F14F9}Prefabs/AI/Waypoints/AIWaypoint.et"),
-				null, position));
+		// El waypoint anterior del grupo vuelve al pool
+		ReleaseWaypoint(groupId);
 
+		AIWaypoint wp = AcquireWaypoint(position);
 		if (!wp) return;
 
 		// Configurar comportamiento del waypoint
@@ -93,6 +233,7 @@ class AIGroupController
 		}
 
 		group.AddWaypoint(wp);
+		m_ActiveWaypoints.Set(groupId, wp);
 	}
 
 	// -------------------------------------------------------
@@ -121,10 +262,11 @@ class AIGroupController
 	}
 
 	// -------------------------------------------------------
-	void SetAmbushPosition(AIGroup group, vector position)
+	void SetAmbushPosition(string groupId, vector position)
 	{
+		AIGroup group = m_Groups.Get(groupId);
 		if (!group) return;
-		SetWaypointWithBehavior(group, position, "DEFEND");
+		SetWaypointWithBehavior(groupId, position, "DEFEND");
 		SetGroupBehavior(group, "STEALTH");
 	}
 
@@ -135,13 +277,18 @@ class AIGroupController
 		string prefabPath = GetTemplatePrefab(faction, template);
 		if (prefabPath == "") return null;
 
-		IEntity groupEnt = GetGame().SpawnEntityPrefab(
-			Resource.Load(prefabPath), null, position);
+		// Con pool: activar y teletransportar un grupo ya creado
+		AIGroup group = TakeWarmGroup(faction + ":" + template, position);
+		if (!group)
+		{
+			IEntity groupEnt = GetGame().SpawnEntityPrefab(
+				GetPrefab(prefabPath), null, position);
 
-		if (!groupEnt) return null;
+			if (!groupEnt) return null;
 
-		AIGroup group = AIGroup.Cast(groupEnt);
-		if (!group) return null;
+			group = AIGroup.Cast(groupEnt);
+			if (!group) return null;
+		}
 
 		string newId = "grp_" + faction.ToLower() + "_" + (m_iGroupCounter++).ToString();
 		RegisterGroup(group, newId);
@@ -149,6 +296,28 @@ class AIGroupController
 		return group;
 	}
 
+	// -------------------------------------------------------
+	// Pool de grupos precargados: se llena poco a poco en segundo plano
+	void StartGroupPools(AIBridgeConfig config)
+	{
+		if (!config.m_aGroupPools) return;
+
+		// 0 0 0 es una esquina real del mapa: sin posición explícita no hay pool
+		if (config.m_vGroupPoolHoldingPosition == vector.Zero)
+		{
+			Print("[ReforgerAI] Pool de grupos desactivado: falta la posición de espera fuera del mapa");
+			return;
+		}
+
+		m_PoolConfig = config;
+
+		foreach (AIGroupPoolConfig pool : config.m_aGroupPools)
+		{
+			m_WarmGroups.Set(pool.m_sFaction + ":" + pool.m_sTemplate, new array<AIGroup>());
+		}
+		GetGame().GetCallqueue().CallLater(FillGroupPools, config.m_fGroupPoolFillInterval * 1000, true);
+	}
+
 	// -------------------------------------------------------
 	void DespawnGroup(string groupId)
 	{
@@ -158,41 +327,77 @@ class AIGroupController
 		// Eliminar unidades del grupo
 		array<AIAgent> agents = new array<AIAgent>();
 		group.GetAgents(agents);
+		UnregisterGroup(groupId, group);
 		foreach (AIAgent agent : agents)
 		{
 			if (agent)
 				SCR_EntityHelper.DeleteEntityAndChildren(agent.GetControlledEntity());
 		}
-		m_Groups.Remove(groupId);
 		Print("[ReforgerAI] Grupo eliminado: " + groupId);
 	}
 
 	// -------------------------------------------------------
-	void SerializeGroups(JsonWriteContext json)
+	void SerializeGroups(JsonWriteContext json, AIStateDelta delta = null)
 	{
+		PruneGroups();
 		foreach (string id, AIGroup group : m_Groups)
 		{
 			if (!group) continue;
-			SerializeGroup(json, id, group);
+			SerializeGroup(json, id, group, delta);
 		}
 	}
 
 	// -------------------------------------------------------
-	private void SerializeGroup(JsonWriteContext json, string id, AIGroup group)
+	void SerializeCacheStats(JsonWriteContext json)
 	{
-		array<AIAgent> agents = new array<AIAgent>();
-		group.GetAgents(agents);
+		json.WriteObjectBegin();
+		json.WriteInt("hits", m_iCacheHits);
+		json.WriteInt("misses", m_iCacheMisses);
+		json.WriteObjectEnd();
+	}
+
+	// -------------------------------------------------------
+	void SerializePoolStats(JsonWriteContext json)
+	{
+		json.WriteObjectBegin();
+		json.WriteInt("prefabs_cached", m_PrefabCache.Count());
+		json.WriteInt("waypoints_active", m_ActiveWaypoints.Count());
+		json.WriteInt("waypoints_free", m_FreeWaypoints.Count());
+		json.WriteInt("waypoints_spawned", m_iWaypointsSpawned);
+		json.WriteInt("waypoints_reused", m_iWaypointsReused);
+		json.WriteInt("group_pool_hits", m_iPoolHits);
+		json.WriteInt("group_pool_misses", m_iPoolMisses);
+
+		int warm = 0;
+		foreach (string key, array<AIGroup> groups : m_WarmGroups)
+		{
+			warm += groups.Count();
+		}
+		json.WriteInt("groups_warm", warm);
+		json.WriteObjectEnd();
+	}
+
+	// -------------------------------------------------------
+	private void SerializeGroup(JsonWriteContext json, string id, AIGroup group, AIStateDelta delta)
+	{
+		AIGroupCacheEntry entry = GetCachedEntry(id, group);
+
+		if (delta)
+		{
+			string signature = entry.m_sFaction + "|" + entry.m_iUnitCount + "|"
+				+ Math.Round(entry.m_fHealthAvg / 5.0) + "|" + entry.m_bHasLeader.ToString();
+			if (!delta.ShouldWrite(AIStateDelta.SECTION_GROUPS, id, entry.m_vLivePos, signature)) return;
+		}
 
 		json.WriteObjectBegin();
 		json.WriteString("group_id", id);
-		json.WriteString("faction", GetGroupFaction(group));
-		json.WriteInt("unit_count", agents.Count());
+		json.WriteString("faction", entry.m_sFaction);
+		json.WriteInt("unit_count", entry.m_iUnitCount);
 
 		// Posición del líder
-		AIAgent leader = group.GetLeader();
-		if (leader && leader.GetControlledEntity())
+		if (entry.m_bHasLeader)
 		{
-			vector pos = leader.GetControlledEntity().GetOrigin();
+			vector pos = entry.m_vLivePos;
 			json.WriteKey("position");
 			json.WriteObjectBegin();
 			json.WriteFloat("x", pos[0]);
@@ -201,19 +406,297 @@ class AIGroupController
 			json.WriteObjectEnd();
 		}
 
-		json.WriteFloat("health_avg", GetGroupAverageHealth(agents));
+		json.WriteFloat("health_avg", entry.m_fHealthAvg);
 		json.WriteObjectEnd();
 	}
 
+	// -------------------------------------------------------
+	// Devuelve la entrada cacheada, recalculándola solo si está sucia,
+	// es demasiado antigua o el líder se ha desplazado lo suficiente.
+	private AIGroupCacheEntry GetCachedEntry(string id, AIGroup group)
+	{
+		AIGroupCacheEntry entry = m_GroupCache.Get(id);
+		if (!entry)
+			entry = CreateCacheEntry(id, group);
+
+		float now = System.GetTickCount();
+		if (!entry.m_bDirty && now - entry.m_fUpdatedAt < CACHE_MAX_AGE_MS)
+		{
+			AIAgent leader = group.GetLeader();
+			IEntity leaderEnt;
+			if (leader) leaderEnt = leader.GetControlledEntity();
+
+			bool leaderMoved = (leaderEnt != null) != entry.m_bHasLeader;
+			if (leaderEnt && !leaderMoved)
+			{
+				// La posición se reporta siempre en vivo; el umbral solo
+				// decide cuándo recalcular facción, unidades y salud
+				entry.m_vLivePos = leaderEnt.GetOrigin();
+				leaderMoved = vector.DistanceSq(entry.m_vLivePos, entry.m_vLeaderPos)
+					> CACHE_MOVE_THRESHOLD * CACHE_MOVE_THRESHOLD;
+			}
+
+			if (!leaderMoved)
+			{
+				m_iCacheHits++;
+				return entry;
+			}
+		}
+
+		m_iCacheMisses++;
+		RefreshEntry(entry, group);
+		return entry;
+	}
+
+	// -------------------------------------------------------
+	// Olvidar un grupo: waypoint al pool, suscripciones fuera
+	private void UnregisterGroup(string groupId, AIGroup group)
+	{
+		ReleaseWaypoint(groupId);
+
+		AIGroupCacheEntry entry = m_GroupCache.Get(groupId);
+		if (entry)
+			entry.m_Listener.Unhook(group);
+
+		m_Groups.Remove(groupId);
+		m_GroupCache.Remove(groupId);
+	}
+
+	// -------------------------------------------------------
+	// Grupos borrados fuera de DespawnGroup (p. ej. al morir todos sus
+	// miembros) se dan de baja; los que se quedan vacíos sueltan su waypoint
+	private void PruneGroups()
+	{
+		array<string> deleted = new array<string>();
+		foreach (string id, AIGroup group : m_Groups)
+		{
+			if (!group)
+			{
+				deleted.Insert(id);
+				continue;
+			}
+
+			AIGroupCacheEntry entry = m_GroupCache.Get(id);
+			if (entry && entry.m_iUnitCount > 0 && group.GetAgentsCount() == 0)
+				ReleaseWaypoint(id);
+		}
+
+		foreach (string id : deleted)
+		{
+			UnregisterGroup(id, null);
+		}
+	}
+
+	// -------------------------------------------------------
+	// Entrada de caché nueva con sus suscripciones a miembros y daño
+	private AIGroupCacheEntry CreateCacheEntry(string id, AIGroup group)
+	{
+		AIGroupCacheEntry entry = new AIGroupCacheEntry();
+		entry.m_Listener = new AIGroupCacheListener(id);
+		entry.m_Listener.HookGroup(group);
+		m_GroupCache.Set(id, entry);
+		return entry;
+	}
+
+	// -------------------------------------------------------
+	private void RefreshEntry(AIGroupCacheEntry entry, AIGroup group)
+	{
+		array<AIAgent> agents = new array<AIAgent>();
+		group.GetAgents(agents);
+
+		entry.m_sFaction = GetGroupFaction(group);
+		entry.m_iUnitCount = agents.Count();
+		entry.m_fHealthAvg = GetGroupAverageHealth(agents, entry.m_Listener);
+
+		AIAgent leader = group.GetLeader();
+		entry.m_bHasLeader = leader && leader.GetControlledEntity();
+		if (entry.m_bHasLeader)
+			entry.m_vLeaderPos = leader.GetControlledEntity().GetOrigin();
+		entry.m_vLivePos = entry.m_vLeaderPos;
+
+		entry.m_bDirty = false;
+		entry.m_fUpdatedAt = System.GetTickCount();
+	}
+
 	// -------------------------------------------------------
 	private string GetTemplatePrefab(string faction, string template)
 	{
-		// Mapa de plantillas — ajusta con los prefabs de tu servidor
-		if (faction == "OPFOR" && template == "infantry_squad")
-			return "{B5DF06B6DCA0D870}Prefabs/Groups/OPFOR/Group_OPFOR_Rifle_Squad.et";
-		if (faction == "BLUFOR" && template == "infantry_squad")
-			return "{A8476E3F6B2B7541}Prefabs/Groups/FIA/Group_FIA_Rifle_Squad.et";
-		return "";
+		return m_TemplatePrefabs.Get(faction + ":" + template);
+	}
+
+	// -------------------------------------------------------
+	private Resource GetPrefab(string path)
+	{
+		Resource res = m_PrefabCache.Get(path);
+		if (!res)
+		{
+			res = Resource.Load(path);
+			if (res && res.IsValid())
+				m_PrefabCache.Set(path, res);
+		}
+		return res;
+	}
+
+	// -------------------------------------------------------
+	// Crear un grupo por llamada para la primera plantilla por debajo de
+	// su tamaño objetivo, solo cuando el bridge está en calma.
+	private void FillGroupPools()
+	{
+		// Los miembros aparecen después que el grupo: ocultar los recién
+		// creados en cada pasada (haya calma o no) hasta que estén todos
+		for (int i = m_HidingGroups.Count() - 1; i >= 0; i--)
+		{
+			AIGroup g = m_HidingGroups[i];
+			if (g) SetGroupDormant(g, true);
+			if (!g || IsFullySpawned(g))
+				m_HidingGroups.Remove(i);
+		}
+
+		AIBridge bridge = AIBridge.GetInstance();
+		if (!bridge || !bridge.IsQuiet()) return;
+
+		foreach (AIGroupPoolConfig pool : m_PoolConfig.m_aGroupPools)
+		{
+			string poolKey = pool.m_sFaction + ":" + pool.m_sTemplate;
+			array<AIGroup> warm = m_WarmGroups.Get(poolKey);
+			if (warm.Count() >= pool.m_iSize) continue;
+
+			string prefabPath = GetTemplatePrefab(pool.m_sFaction, pool.m_sTemplate);
+			if (prefabPath == "") continue;
+
+			AIGroup group = AIGroup.Cast(GetGame().SpawnEntityPrefab(
+				GetPrefab(prefabPath), null, m_PoolConfig.m_vGroupPoolHoldingPosition));
+			if (!group) continue;
+
+			SetGroupDormant(group, true);
+			warm.Insert(group);
+			m_HidingGroups.Insert(group);
+			return;
+		}
+	}
+
+	// -------------------------------------------------------
+	private AIGroup TakeWarmGroup(string poolKey, vector position)
+	{
+		if (!m_PoolConfig) return null;
+
+		array<AIGroup> warm = m_WarmGroups.Get(poolKey);
+		if (warm)
+		{
+			for (int i = warm.Count() - 1; i >= 0; i--)
+			{
+				AIGroup group = warm[i];
+				if (!group)
+				{
+					warm.Remove(i);
+					continue;
+				}
+				// Los que aún esperan miembros se quedan en el pool, ocultos
+				if (!IsFullySpawned(group)) continue;
+
+				warm.Remove(i);
+				m_HidingGroups.RemoveItem(group);
+				TeleportGroup(group, position);
+				SetGroupDormant(group, false);
+				m_iPoolHits++;
+				return group;
+			}
+		}
+
+		m_iPoolMisses++;
+		return null;
+	}
+
+	// -------------------------------------------------------
+	// ¿Han aparecido ya todos los miembros de la plantilla?
+	private bool IsFullySpawned(AIGroup group)
+	{
+		SCR_AIGroup scrGroup = SCR_AIGroup.Cast(group);
+		if (!scrGroup)
+			return group.GetAgentsCount() > 0;
+		return group.GetAgentsCount() >= Math.Max(1, scrGroup.GetNumberOfMembersToSpawn());
+	}
+
+	// -------------------------------------------------------
+	// Ocultar y desactivar (o reactivar) la IA de todos los miembros
+	private void SetGroupDormant(AIGroup group, bool dormant)
+	{
+		array<AIAgent> agents = new array<AIAgent>();
+		group.GetAgents(agents);
+		foreach (AIAgent agent : agents)
+		{
+			if (!agent) continue;
+			IEntity ent = agent.GetControlledEntity();
+
+			if (dormant)
+			{
+				agent.DeactivateAI();
+				if (ent) ent.ClearFlags(EntityFlags.VISIBLE | EntityFlags.ACTIVE);
+			}
+			else
+			{
+				if (ent) ent.SetFlags(EntityFlags.VISIBLE | EntityFlags.ACTIVE);
+				agent.ActivateAI();
+			}
+		}
+	}
+
+	// -------------------------------------------------------
+	// Mover el grupo conservando la disposición relativa al líder
+	private void TeleportGroup(AIGroup group, vector position)
+	{
+		vector anchor = group.GetOrigin();
+		AIAgent leader = group.GetLeader();
+		if (leader && leader.GetControlledEntity())
+			anchor = leader.GetControlledEntity().GetOrigin();
+
+		array<AIAgent> agents = new array<AIAgent>();
+		group.GetAgents(agents);
+		foreach (AIAgent agent : agents)
+		{
+			if (!agent || !agent.GetControlledEntity()) continue;
+			IEntity ent = agent.GetControlledEntity();
+			ent.SetOrigin(position + (ent.GetOrigin() - anchor));
+		}
+		group.SetOrigin(position);
+	}
+
+	// -------------------------------------------------------
+	// Tomar un waypoint del pool o crear uno nuevo
+	private AIWaypoint AcquireWaypoint(vector position)
+	{
+		while (!m_FreeWaypoints.IsEmpty())
+		{
+			AIWaypoint wp = m_FreeWaypoints[m_FreeWaypoints.Count() - 1];
+			m_FreeWaypoints.Remove(m_FreeWaypoints.Count() - 1);
+			if (!wp) continue;
+
+			// Sin el tipo anterior: un comportamiento desconocido no lo hereda
+			wp.SetOrigin(position);
+			wp.SetCompletionType(AIWaypointCompletionType.MOVE);
+			m_iWaypointsReused++;
+			return wp;
+		}
+
+		m_iWaypointsSpawned++;
+		return AIWaypoint.Cast(GetGame().SpawnEntityPrefab(GetPrefab(WAYPOINT_PREFAB), null, position));
+	}
+
+	// -------------------------------------------------------
+	// Quitar el waypoint activo del grupo y devolverlo al pool
+	private void ReleaseWaypoint(string groupId)
+	{
+		AIWaypoint wp = m_ActiveWaypoints.Get(groupId);
+		m_ActiveWaypoints.Remove(groupId);
+		if (!wp) return;
+
+		AIGroup group = m_Groups.Get(groupId);
+		if (group)
+			group.RemoveWaypoint(wp);
+		if (m_FreeWaypoints.Count() < MAX_FREE_WAYPOINTS)
+			m_FreeWaypoints.Insert(wp);
+		else
+			SCR_EntityHelper.DeleteEntityAndChildren(wp);
 	}
 
 	private string GetGroupFaction(AIGroup group)
@@ -228,7 +711,7 @@ class AIGroupController
 		return fac.GetAffiliatedFaction().GetFactionKey();
 	}
 
-	private float GetGroupAverageHealth(array<AIAgent> agents)
+	private float GetGroupAverageHealth(array<AIAgent> agents, AIGroupCacheListener listener = null)
 	{
 		if (agents.IsEmpty()) return 0;
 		float total = 0;
@@ -238,6 +721,7 @@ class AIGroupController
 			SCR_CharacterDamageManagerComponent dmg = SCR_CharacterDamageManagerComponent.Cast(
 				agent.GetControlledEntity().FindComponent(SCR_CharacterDamageManagerComponent));
 			total += dmg ? dmg.GetHealthScaled() * 100.0 : 100.0;
+			if (listener) listener.HookDamage(dmg);
 		}
 		return total / agents.Count();
 	}
@@ -12,6 +12,7 @@ class MissionData
 	ref array<string> assignedGroups;
 	float timeRemaining;
 	float completion;
+	string controllingFaction; // facción que ocupó el objetivo por última vez
 
 	void MissionData()
 	{
@@ -28,6 +29,9 @@ class AIMissionManager
 	private ref map<string, ref MissionData> m_Missions;
 	private int m_iMissionCounter;
 
+	// Radio alrededor del objetivo en el que se cuenta la presencia (m)
+	static const float OBJECTIVE_CAPTURE_RADIUS = 50.0;
+
 	static AIMissionManager GetInstance()
 	{
 		if (!s_Instance) s_Instance = new AIMissionManager();
@@ -104,12 +108,52 @@ class AIMissionManager
 	}
 
 	// -------------------------------------------------------
-	void SerializeActiveMissions(JsonWriteContext json)
+	// Un objetivo cambia de manos cuando dentro de su radio solo quedan
+	// jugadores vivos de una facción distinta a la que lo ocupaba.
+	// Llamar tras refrescar la caché de jugadores del tick.
+	void UpdateObjectiveControl(AIPlayerCache players, AIEventDispatcher events)
 	{
+		float radiusSq = OBJECTIVE_CAPTURE_RADIUS * OBJECTIVE_CAPTURE_RADIUS;
 		foreach (string id, MissionData md : m_Missions)
 		{
 			if (!md || md.status != "ACTIVE") continue;
 
+			string holder;
+			bool contested = false;
+			foreach (int pid, AIPlayerRecord rec : players.GetRecords())
+			{
+				if (!rec.m_Entity || !rec.IsAlive()) continue;
+				if (vector.DistanceSq(rec.m_Entity.GetOrigin(), md.objectivePosition) > radiusSq) continue;
+
+				string faction = rec.GetFactionKey();
+				if (holder.IsEmpty())
+					holder = faction;
+				else if (holder != faction)
+					contested = true;
+			}
+
+			if (holder.IsEmpty() || contested || holder == md.controllingFaction) continue;
+
+			md.controllingFaction = holder;
+			events.OnObjectiveCaptured(md.missionId, holder, md.objectivePosition);
+			Print("[ReforgerAI] Objetivo de " + md.missionId + " capturado por " + holder);
+		}
+	}
+
+	// -------------------------------------------------------
+	void SerializeActiveMissions(JsonWriteContext json, AIStateDelta delta = null)
+	{
+		foreach (string id, MissionData md : m_Missions)
+		{
+			if (!md || md.status != "ACTIVE") continue;
+
+			if (delta)
+			{
+				string signature = md.type + "|" + md.status + "|" + md.completion;
+				if (!delta.ShouldWrite(AIStateDelta.SECTION_MISSIONS, md.missionId, md.objectivePosition, signature))
+					continue;
+			}
+
 			json.WriteObjectBegin();
 			json.WriteString("mission_id", md.missionId);
 			json.WriteString("type", md.type);
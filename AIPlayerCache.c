@@ -0,0 +1,151 @@
+// ============================================================
+// AIPlayerCache.c — Caché de jugadores y sus componentes
+// ReforgerAI Mod v1.0.0
+// ============================================================
+
+class AIPlayerRecord
+{
+	int m_iPlayerId;
+	string m_sId;
+	string m_sName;
+	IEntity m_Entity;
+	CharacterControllerComponent m_Controller;
+	FactionAffiliationComponent m_Faction;
+	SCR_CharacterDamageManagerComponent m_Damage;
+	CompartmentAccessComponent m_Compartment;
+
+	void AIPlayerRecord(int playerId)
+	{
+		m_iPlayerId = playerId;
+		m_sId = "player_" + playerId.ToString();
+		m_sName = GetGame().GetPlayerManager().GetPlayerName(playerId);
+	}
+
+	// -------------------------------------------------------
+	// Resolver los componentes una sola vez por entidad controlada
+	void Resolve(IEntity ent)
+	{
+		m_Entity = ent;
+		m_Controller = null;
+		m_Faction = null;
+		m_Damage = null;
+		m_Compartment = null;
+		if (!ent) return;
+
+		m_Controller = CharacterControllerComponent.Cast(ent.FindComponent(CharacterControllerComponent));
+		m_Faction = FactionAffiliationComponent.Cast(ent.FindComponent(FactionAffiliationComponent));
+		m_Damage = SCR_CharacterDamageManagerComponent.Cast(ent.FindComponent(SCR_CharacterDamageManagerComponent));
+		m_Compartment = CompartmentAccessComponent.Cast(ent.FindComponent(CompartmentAccessComponent));
+	}
+
+	// -------------------------------------------------------
+	string GetFactionKey()
+	{
+		if (!m_Faction) return "UNKNOWN";
+		Faction f = m_Faction.GetAffiliatedFaction();
+		if (!f) return "UNKNOWN";
+		return f.GetFactionKey();
+	}
+
+	float GetHealth()
+	{
+		if (!m_Damage) return 100.0;
+		return m_Damage.GetHealthScaled() * 100.0;
+	}
+
+	bool IsAlive()
+	{
+		return m_Controller && !m_Controller.IsDead();
+	}
+
+	bool IsInVehicle()
+	{
+		return m_Compartment && m_Compartment.IsInCompartment();
+	}
+}
+
+// Mantiene un registro por jugador actualizado con los eventos del modo
+// de juego, en lugar de recorrer GetPlayers() y FindComponent cada tick.
+class AIPlayerCache
+{
+	private AIBridge m_Bridge;
+	private ref map<int, ref AIPlayerRecord> m_Records;
+	private int m_iResolves;
+
+	void AIPlayerCache(AIBridge bridge)
+	{
+		m_Bridge = bridge;
+		m_Records = new map<int, ref AIPlayerRecord>();
+
+		SCR_BaseGameMode gameMode = SCR_BaseGameMode.Cast(GetGame().GetGameMode());
+		if (gameMode)
+		{
+			gameMode.GetOnPlayerConnected().Insert(OnPlayerConnected);
+			gameMode.GetOnPlayerDisconnected().Insert(OnPlayerDisconnected);
+			gameMode.GetOnPlayerSpawned().Insert(OnPlayerSpawned);
+		}
+
+		// Jugadores ya conectados cuando arranca el bridge
+		array<int> players = new array<int>();
+		GetGame().GetPlayerManager().GetPlayers(players);
+		foreach (int pid : players)
+		{
+			OnPlayerConnected(pid);
+		}
+	}
+
+	// -------------------------------------------------------
+	void OnPlayerConnected(int playerId)
+	{
+		AIPlayerRecord rec = new AIPlayerRecord(playerId);
+		m_Records.Set(playerId, rec);
+		Refresh(rec);
+	}
+
+	void OnPlayerDisconnected(int playerId, KickCauseCode cause, int timeout)
+	{
+		m_Records.Remove(playerId);
+	}
+
+	void OnPlayerSpawned(int playerId, IEntity controlledEntity)
+	{
+		AIPlayerRecord rec = m_Records.Get(playerId);
+		if (!rec)
+		{
+			OnPlayerConnected(playerId);
+			return;
+		}
+		rec.Resolve(controlledEntity);
+		m_iResolves++;
+	}
+
+	// -------------------------------------------------------
+	map<int, ref AIPlayerRecord> GetRecords()
+	{
+		return m_Records;
+	}
+
+	// -------------------------------------------------------
+	// Comprobar que el registro sigue apuntando a la entidad controlada
+	// (respawn, posesión, cambio de personaje). Devuelve false si el
+	// jugador no controla ninguna entidad ahora mismo.
+	bool Refresh(AIPlayerRecord rec)
+	{
+		IEntity current = GetGame().GetPlayerManager().GetPlayerControlledEntity(rec.m_iPlayerId);
+		if (current != rec.m_Entity)
+		{
+			rec.Resolve(current);
+			m_iResolves++;
+		}
+		return current != null;
+	}
+
+	// -------------------------------------------------------
+	void SerializeStats(JsonWriteContext json)
+	{
+		json.WriteObjectBegin();
+		json.WriteInt("records", m_Records.Count());
+		json.WriteInt("resolves", m_iResolves);
+		json.WriteObjectEnd();
+	}
+}
@@ -0,0 +1,217 @@
+// ============================================================
+// AIRequestScheduler.c — Control de peticiones en vuelo y tick adaptativo
+// ReforgerAI Mod v1.0.0
+// ============================================================
+
+class AIPendingRequest
+{
+	int m_iTick;
+	float m_fSentAt;      // ms (System.GetTickCount)
+	float m_fLastActivity; // ms, última parte recibida
+	RestCallback m_Rest;   // llamada HTTP en curso (débil: la libera el motor)
+
+	void AIPendingRequest(int tick, float sentAt)
+	{
+		m_iTick = tick;
+		m_fSentAt = sentAt;
+		m_fLastActivity = sentAt;
+	}
+
+	// -------------------------------------------------------
+	// Asociar la llamada HTTP que responderá a esta petición
+	void Attach(RestCallback cb)
+	{
+		m_Rest = cb;
+	}
+
+	// Desconectar el callback: una respuesta tardía ya no llega a este objeto
+	void Detach()
+	{
+		if (m_Rest)
+			m_Rest.m_Callback = null;
+		m_Rest = null;
+	}
+
+	// -------------------------------------------------------
+	// Callback HTTP: reenvía la respuesta al bridge con el tick de origen
+	void OnResponse(int code, string data)
+	{
+		AIBridge bridge = AIBridge.GetInstance();
+		if (bridge)
+			bridge.OnAIResponse(m_iTick, code, data);
+	}
+
+	// Callback de GET /result/<id>
+	void OnResultResponse(int code, string data)
+	{
+		AIBridge bridge = AIBridge.GetInstance();
+		if (bridge)
+			bridge.OnResultResponse(m_iTick, code, data);
+	}
+}
+
+class AIRequestScheduler
+{
+	private AIBridge m_Bridge;
+	private ref map<int, ref AIPendingRequest> m_InFlight;
+	private int m_iLastAppliedTick;
+	private float m_fRttAvg;          // ms, media exponencial
+	private float m_fCurrentInterval; // s
+	private int m_iDroppedStale;
+	private int m_iExpired;
+	private int m_iDeferred;
+	private bool m_bDeferring;        // el tick actual ya se contó como aplazado
+
+	// Peso de la última muestra en la media de latencia
+	static const float RTT_SMOOTHING = 0.3;
+
+	void AIRequestScheduler(AIBridge bridge)
+	{
+		m_Bridge = bridge;
+		m_InFlight = new map<int, ref AIPendingRequest>();
+		m_iLastAppliedTick = 0;
+		m_fRttAvg = 0;
+		m_fCurrentInterval = bridge.m_Config.m_fTickInterval;
+	}
+
+	// -------------------------------------------------------
+	// ¿Hay hueco para otra petición?
+	bool CanSend()
+	{
+		ExpireTimedOut();
+		if (m_InFlight.Count() < Math.Max(1, m_Bridge.m_Config.m_iMaxInFlight))
+		{
+			m_bDeferring = false;
+			return true;
+		}
+
+		// Se consulta cada frame: contar una vez por tick aplazado
+		if (!m_bDeferring)
+		{
+			m_iDeferred++;
+			m_bDeferring = true;
+		}
+		return false;
+	}
+
+	// -------------------------------------------------------
+	// Registrar una petición enviada; devuelve el objeto que recibe la respuesta
+	AIPendingRequest Begin(int tick)
+	{
+		AIPendingRequest req = new AIPendingRequest(tick, System.GetTickCount());
+		m_InFlight.Set(tick, req);
+		return req;
+	}
+
+	AIPendingRequest Get(int tick)
+	{
+		return m_InFlight.Get(tick);
+	}
+
+	// -------------------------------------------------------
+	// ¿Se pueden aplicar comandos de este tick? Devuelve false si la
+	// respuesta es obsoleta (ya se aplicó un tick más reciente) o si la
+	// petición había expirado. Una respuesta puede llegar en varias partes.
+	bool Accept(int tick)
+	{
+		AIPendingRequest req = m_InFlight.Get(tick);
+		if (!req) return false;
+
+		if (tick < m_iLastAppliedTick)
+		{
+			m_iDroppedStale++;
+			if (m_Bridge.m_Config.m_bDebugMode)
+				Print("[ReforgerAI] Respuesta obsoleta descartada (tick " + tick + " < " + m_iLastAppliedTick + ")");
+			return false;
+		}
+
+		m_iLastAppliedTick = tick;
+		req.m_fLastActivity = System.GetTickCount();
+		return true;
+	}
+
+	// -------------------------------------------------------
+	// Cerrar una petición tras su última parte y medir la latencia
+	void Finish(int tick)
+	{
+		AIPendingRequest req = m_InFlight.Get(tick);
+		if (!req) return;
+
+		m_InFlight.Remove(tick);
+		RecordLatency(System.GetTickCount() - req.m_fSentAt);
+	}
+
+	// -------------------------------------------------------
+	// Liberar una petición fallida sin aplicar nada
+	void Abort(int tick)
+	{
+		m_InFlight.Remove(tick);
+	}
+
+	// -------------------------------------------------------
+	// Intervalo de envío actual (s)
+	float GetInterval()
+	{
+		return m_fCurrentInterval;
+	}
+
+	// -------------------------------------------------------
+	void SerializeStats(JsonWriteContext json)
+	{
+		json.WriteObjectBegin();
+		json.WriteInt("in_flight", m_InFlight.Count());
+		json.WriteFloat("rtt_avg_ms", m_fRttAvg);
+		json.WriteFloat("tick_interval_s", m_fCurrentInterval);
+		json.WriteInt("dropped_stale", m_iDroppedStale);
+		json.WriteInt("expired", m_iExpired);
+		json.WriteInt("deferred", m_iDeferred);
+		json.WriteObjectEnd();
+	}
+
+	// -------------------------------------------------------
+	// Ajusta el intervalo para que con N peticiones en vuelo el servicio
+	// reciba un estado nuevo aproximadamente cuando termina el anterior.
+	private void RecordLatency(float rttMs)
+	{
+		if (m_fRttAvg <= 0)
+			m_fRttAvg = rttMs;
+		else
+			m_fRttAvg += (rttMs - m_fRttAvg) * RTT_SMOOTHING;
+
+		AIBridgeConfig cfg = m_Bridge.m_Config;
+		if (!cfg.m_bAdaptiveTick)
+		{
+			m_fCurrentInterval = cfg.m_fTickInterval;
+			return;
+		}
+
+		float target = (m_fRttAvg / 1000.0) / Math.Max(1, cfg.m_iMaxInFlight);
+		m_fCurrentInterval = Math.Clamp(target, cfg.m_fTickInterval, Math.Max(cfg.m_fTickInterval, cfg.m_fMaxTickInterval));
+	}
+
+	// -------------------------------------------------------
+	// Liberar huecos de peticiones cuya respuesta (o siguiente parte) nunca llegó
+	private void ExpireTimedOut()
+	{
+		float now = System.GetTickCount();
+		float timeoutMs = m_Bridge.m_Config.m_fRequestTimeout * 1000.0;
+
+		array<int> expired = new array<int>();
+		foreach (int tick, AIPendingRequest req : m_InFlight)
+		{
+			if (now - req.m_fLastActivity > timeoutMs)
+				expired.Insert(tick);
+		}
+
+		foreach (int tick : expired)
+		{
+			m_InFlight.Get(tick).Detach();
+			m_InFlight.Remove(tick);
+			m_Bridge.OnRequestExpired(tick);
+			m_iExpired++;
+			RecordLatency(timeoutMs);
+			if (m_Bridge.m_Config.m_bDebugMode)
+				Print("[ReforgerAI] Petición expirada: tick " + tick);
+		}
+	}
+}
@@ -0,0 +1,209 @@
+// ============================================================
+// AIStateDelta.c — Codificación delta del GameState
+// ReforgerAI Mod v1.0.0
+// ============================================================
+
+class AISnapshotEntry
+{
+	string m_sSection;
+	string m_sId;
+	vector m_vPosition;
+	string m_sSignature;
+
+	void AISnapshotEntry(string section, string id, vector pos, string signature)
+	{
+		m_sSection = section;
+		m_sId = id;
+		m_vPosition = pos;
+		m_sSignature = signature;
+	}
+}
+
+class AIStateSnapshot
+{
+	int m_iTick;
+	ref map<string, ref AISnapshotEntry> m_Entries;
+
+	void AIStateSnapshot(int tick)
+	{
+		m_iTick = tick;
+		m_Entries = new map<string, ref AISnapshotEntry>();
+	}
+}
+
+// Mantiene el último snapshot confirmado por el servicio y decide qué
+// jugadores, grupos y misiones hay que reenviar en cada tick.
+class AIStateDelta
+{
+	private AIBridge m_Bridge;
+	private ref AIStateSnapshot m_Base;
+	private ref AIStateSnapshot m_Building;
+	private ref map<int, ref AIStateSnapshot> m_Pending;
+	private bool m_bKeyframe;
+	private bool m_bForceKeyframe;
+	private int m_iLastKeyframeTick;
+	private int m_iWritten;
+	private int m_iSkipped;
+
+	// Snapshots sin confirmar que se conservan como máximo
+	static const int MAX_PENDING = 16;
+
+	static const string SECTION_PLAYERS = "players";
+	static const string SECTION_GROUPS = "ai_groups";
+	static const string SECTION_MISSIONS = "active_missions";
+
+	void AIStateDelta(AIBridge bridge)
+	{
+		m_Bridge = bridge;
+		m_Pending = new map<int, ref AIStateSnapshot>();
+		m_bForceKeyframe = true;
+	}
+
+	// -------------------------------------------------------
+	// Preparar el snapshot del tick y decidir si es keyframe
+	void BeginTick(int tick)
+	{
+		AIBridgeConfig cfg = m_Bridge.m_Config;
+		m_bKeyframe = !cfg.m_bDeltaState || !m_Base || m_bForceKeyframe
+			|| tick - m_iLastKeyframeTick >= cfg.m_iKeyframeInterval;
+
+		if (m_bKeyframe)
+		{
+			m_iLastKeyframeTick = tick;
+			m_bForceKeyframe = false;
+		}
+
+		m_Building = new AIStateSnapshot(tick);
+		m_iWritten = 0;
+		m_iSkipped = 0;
+	}
+
+	// -------------------------------------------------------
+	bool IsKeyframe()
+	{
+		return m_bKeyframe;
+	}
+
+	int GetBaseTick()
+	{
+		if (!m_Base) return 0;
+		return m_Base.m_iTick;
+	}
+
+	// -------------------------------------------------------
+	// Registrar una entidad en el snapshot actual. Devuelve true si hay
+	// que serializarla (nueva, cambiada o keyframe).
+	bool ShouldWrite(string section, string id, vector pos, string signature)
+	{
+		string key = section + "/" + id;
+
+		AISnapshotEntry prev;
+		if (!m_bKeyframe)
+			prev = m_Base.m_Entries.Get(key);
+
+		float threshold = m_Bridge.m_Config.m_fDeltaPositionThreshold;
+		if (prev && prev.m_sSignature == signature
+			&& vector.DistanceSq(prev.m_vPosition, pos) <= threshold * threshold)
+		{
+			// Sin cambios: el servicio conserva la versión base
+			m_Building.m_Entries.Set(key, prev);
+			m_iSkipped++;
+			return false;
+		}
+
+		m_Building.m_Entries.Set(key, new AISnapshotEntry(section, id, pos, signature));
+		m_iWritten++;
+		return true;
+	}
+
+	// -------------------------------------------------------
+	// Escribir las entidades presentes en la base que ya no existen
+	void WriteRemoved(JsonWriteContext json)
+	{
+		json.WriteObjectBegin();
+		WriteRemovedSection(json, SECTION_PLAYERS);
+		WriteRemovedSection(json, SECTION_GROUPS);
+		WriteRemovedSection(json, SECTION_MISSIONS);
+		json.WriteObjectEnd();
+	}
+
+	// -------------------------------------------------------
+	// Cerrar el tick: el snapshot queda pendiente de confirmación
+	void EndTick()
+	{
+		m_Pending.Set(m_Building.m_iTick, m_Building);
+
+		if (m_Pending.Count() > MAX_PENDING)
+		{
+			int oldest = m_Building.m_iTick;
+			foreach (int tick, AIStateSnapshot snap : m_Pending)
+			{
+				if (tick < oldest) oldest = tick;
+			}
+			m_Pending.Remove(oldest);
+		}
+
+		m_Building = null;
+	}
+
+	// -------------------------------------------------------
+	// El servicio ha recibido el tick: pasa a ser la nueva base
+	void Acknowledge(int tick)
+	{
+		AIStateSnapshot snap = m_Pending.Get(tick);
+		if (!snap) return;
+
+		if (!m_Base || tick > m_Base.m_iTick)
+			m_Base = snap;
+
+		array<int> done = new array<int>();
+		foreach (int t, AIStateSnapshot s : m_Pending)
+		{
+			if (t <= tick) done.Insert(t);
+		}
+		foreach (int t : done)
+		{
+			m_Pending.Remove(t);
+		}
+	}
+
+	// -------------------------------------------------------
+	void Discard(int tick)
+	{
+		m_Pending.Remove(tick);
+	}
+
+	// -------------------------------------------------------
+	// El servicio no conoce nuestra base: el próximo envío será completo
+	void RequestKeyframe()
+	{
+		m_bForceKeyframe = true;
+	}
+
+	// -------------------------------------------------------
+	void SerializeStats(JsonWriteContext json)
+	{
+		json.WriteObjectBegin();
+		json.WriteBool("keyframe", m_bKeyframe);
+		json.WriteInt("entities_written", m_iWritten);
+		json.WriteInt("entities_skipped", m_iSkipped);
+		json.WriteObjectEnd();
+	}
+
+	// -------------------------------------------------------
+	private void WriteRemovedSection(JsonWriteContext json, string section)
+	{
+		json.WriteKey(section);
+		json.WriteArrayBegin();
+		foreach (string key, AISnapshotEntry entry : m_Base.m_Entries)
+		{
+			if (entry.m_sSection != section) continue;
+			if (m_Building.m_Entries.Contains(key)) continue;
+
+			json.WriteObjectBegin();
+			json.WriteString("id", entry.m_sId);
+			json.WriteObjectEnd();
+		}
+		json.WriteArrayEnd();
+	}
+}
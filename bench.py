@@ -0,0 +1,290 @@
+#!/usr/bin/env python3
+"""
+bench.py — Banco de pruebas offline del servicio
+Reproduce una sesión grabada con RAI_REPLAY_LOG (o una sintética) contra
+ReforgerAIService.handle_command, con un Ollama simulado en proceso, e
+informa de latencias p50/p95/p99, throughput, rechazo de órdenes y tokens
+por tick. Respeta las variables RAI_*, así que dos ejecuciones con distinta
+configuración sobre el mismo replay son directamente comparables.
+
+Uso:
+  python bench.py sesion.jsonl --speed 1        # ritmo real
+  python bench.py sesion.jsonl --speed 10       # 10x
+  python bench.py --synthetic 300 --speed 0     # secuencial, sin esperas
+"""
+
+import argparse
+import asyncio
+import json
+import logging
+import math
+import random
+import time
+import config as cfg
+from main import ReforgerAIService
+from llm_client import PROMPTS
+from replay import load_replay
+from state_compressor import estimate_tokens
+from tactical_planner import TacticalPlanner
+
+# Intervalo entre ticks de las sesiones sintéticas (el del mod por defecto)
+SYNTHETIC_TICK_S = 2.0
+
+
+class BenchRequest:
+    """Lo mínimo de web.Request que usan los handlers."""
+
+    def __init__(self, body: str = "", match_info: dict = None):
+        self._body = body
+        self.match_info = match_info or {}
+        self.query = {}
+
+    async def text(self) -> str:
+        return self._body
+
+
+# ─── Ollama simulado ─────────────────────────────────────────
+class MockOllama:
+    """
+    Sustituye generate/generate_stream de OllamaClient. La latencia sigue
+    el modelo prefill + decodificación: ms por token de prompt más ms por
+    token generado, con un ruido de ±jitter. Las respuestas son las
+    grabadas para ese (session_id, tick), o una orden vacía.
+    """
+
+    def __init__(self, llm, responses: dict, prefill_ms: float, decode_ms: float, jitter: float):
+        self.llm = llm
+        self.responses = responses
+        self.prefill_ms = prefill_ms
+        self.decode_ms = decode_ms
+        self.jitter = jitter
+
+    def install(self):
+        self.llm.generate = self.generate
+        self.llm.generate_stream = self.generate_stream
+
+    def _response_for(self, context: str) -> str:
+        try:
+            state = json.loads(context)
+        except ValueError:
+            state = {}
+        text = self.responses.get((state.get("session_id"), state.get("tick")))
+        return text or json.dumps({"reasoning": "mock", "commands": []})
+
+    def _timing(self, context: str, text: str, tier: str) -> dict:
+        prompt_tokens = estimate_tokens(PROMPTS[tier][0]) + estimate_tokens(context)
+        eval_tokens = estimate_tokens(text)
+        noise = 1 + random.uniform(-self.jitter, self.jitter)
+        return {
+            "prompt_eval_count": prompt_tokens,
+            "prompt_eval_duration": prompt_tokens * self.prefill_ms * noise * 1e6,
+            "eval_count": eval_tokens,
+            "eval_duration": eval_tokens * self.decode_ms * noise * 1e6
+        }
+
+    async def generate(self, game_state_json: str, session_id: str = None, model: str = None,
+                       tier: str = "full") -> str:
+        text = self._response_for(game_state_json)
+        data = self._timing(game_state_json, text, tier)
+        await asyncio.sleep((data["prompt_eval_duration"] + data["eval_duration"]) / 1e9)
+        self.llm._record_timing(data, None, tier)
+        return text
+
+    async def generate_stream(self, game_state_json: str, parser, session_id: str = None, model: str = None):
+        text = self._response_for(game_state_json)
+        data = self._timing(game_state_json, text, "full")
+        await asyncio.sleep(data["prompt_eval_duration"] / 1e9)
+        # Trozos de ~8 tokens al ritmo de decodificación
+        step = 26
+        per_chunk = data["eval_duration"] / 1e9 / max(1, math.ceil(len(text) / step))
+        for i in range(0, len(text), step):
+            await asyncio.sleep(per_chunk)
+            for cmd in parser.feed(text[i:i + step]):
+                yield cmd
+        self.llm._record_timing(data, None, "full")
+
+
+# ─── Sesión sintética ────────────────────────────────────────
+def synthetic_session(ticks: int, groups: int, players: int, seed: int):
+    """Registros tipo replay de una partida simple: jugadores que avanzan
+    hacia los grupos IA, con contactos cuando se acercan. Las respuestas
+    del modelo simulado las genera el planificador por reglas."""
+    rng = random.Random(seed)
+    planner = TacticalPlanner()
+    session = f"bench_{seed}"
+    # Mismos campos que escriben AIGroupController y AIBridge
+    ai = [{"group_id": f"grp_opfor_{i:03d}", "faction": "OPFOR", "unit_count": 4,
+           "position": {"x": rng.uniform(3000, 9000), "y": 0.0, "z": rng.uniform(3000, 9000)},
+           "health_avg": 100}
+          for i in range(groups)]
+    pl = [{"id": f"player_{i:03d}", "name": f"Jugador {i}", "faction": "BLUFOR",
+           "alive": True, "health": 100, "in_vehicle": False,
+           "position": {"x": rng.uniform(1000, 2000), "y": 0.0, "z": rng.uniform(1000, 2000)}}
+          for i in range(players)]
+
+    records, responses = [], {}
+    for tick in range(ticks):
+        for p in pl:
+            p["position"]["x"] += rng.uniform(-5, 40)
+            p["position"]["z"] += rng.uniform(-5, 40)
+        events = []
+        for g in ai:
+            g["position"]["x"] += rng.uniform(-10, 10)
+            g["position"]["z"] += rng.uniform(-10, 10)
+            for p in pl:
+                d = math.hypot(p["position"]["x"] - g["position"]["x"], p["position"]["z"] - g["position"]["z"])
+                if d < 400 and rng.random() < 0.3:
+                    events.append({"type": "CONTACT_SPOTTED", "source_group": g["group_id"],
+                                   "timestamp": tick * SYNTHETIC_TICK_S,
+                                   "data": {"enemy_position": dict(p["position"]), "distance": round(d, 1)}})
+                    break
+        state = {"timestamp": tick * SYNTHETIC_TICK_S, "session_id": session, "tick": tick,
+                 "map": "Everon", "players": pl, "ai_groups": ai, "events": events,
+                 "active_missions": [{"mission_id": "mission_001", "type": "DEFEND", "status": "ACTIVE",
+                                      "assigned_groups": [ai[0]["group_id"]] if ai else []}]}
+        state = json.loads(json.dumps(state))
+        responses[(session, tick)] = json.dumps(planner.plan(state, "bench"))
+        records.append({"t": tick * SYNTHETIC_TICK_S, "state": state})
+    return records, responses
+
+
+# ─── Reproducción ────────────────────────────────────────────
+def percentile(sorted_values: list, p: float) -> float:
+    if not sorted_values:
+        return 0.0
+    k = max(0, math.ceil(p / 100 * len(sorted_values)) - 1)
+    return round(sorted_values[k], 1)
+
+
+async def run_replay(service: ReforgerAIService, records: list, speed: float) -> dict:
+    latencies, statuses = [], {}
+
+    async def send(rec):
+        t0 = time.perf_counter()
+        resp = await service.handle_command(BenchRequest(json.dumps(rec["state"])))
+        body = json.loads(resp.text) if resp.status in (200, 202) else {}
+        # Respuestas parciales / trabajos: recoger hasta el final
+        while body.get("more"):
+            resp = await service.handle_result(BenchRequest(match_info={"result_id": body["result_id"]}))
+            body = json.loads(resp.text) if resp.status == 200 else {}
+        latencies.append((time.perf_counter() - t0) * 1000)
+        statuses[resp.status] = statuses.get(resp.status, 0) + 1
+
+    base = records[0].get("t", 0.0) if records else 0.0
+    start = time.perf_counter()
+    tasks = []
+    for rec in records:
+        if speed <= 0:
+            await send(rec)
+            continue
+        # Bucle abierto: cada estado sale a su hora aunque el anterior no haya vuelto
+        delay = (rec.get("t", 0.0) - base) / speed - (time.perf_counter() - start)
+        if delay > 0:
+            await asyncio.sleep(delay)
+        tasks.append(asyncio.create_task(send(rec)))
+    await asyncio.gather(*tasks)
+    wall = time.perf_counter() - start
+
+    latencies.sort()
+    stats = json.loads((await service.handle_stats(None)).text)
+    timing = service.llm.timing
+    n = max(1, len(records))
+    return {
+        "requests": len(records),
+        "wall_s": round(wall, 2),
+        "throughput_rps": round(len(records) / wall, 2) if wall else 0.0,
+        "latency_ms": {
+            "p50": percentile(latencies, 50),
+            "p95": percentile(latencies, 95),
+            "p99": percentile(latencies, 99),
+            "max": round(latencies[-1], 1) if latencies else 0.0,
+            "mean": round(sum(latencies) / len(latencies), 1) if latencies else 0.0
+        },
+        "status": statuses,
+        "validation": {
+            "llm_commands": stats["llm_commands"],
+            "rejected": stats["llm_commands_rejected"],
+            "rejection_rate": stats["rejection_rate"],
+            "batches_rejected": stats["llm_batches_rejected"],
+            "planner_fallbacks": stats["planner_fallbacks"]
+        },
+        "llm_calls": timing["calls"],
+        "tokens_per_tick": {
+            "prompt": round(timing["prompt_eval_tokens"] / n, 1),
+            "eval": round(timing["eval_tokens"] / n, 1)
+        },
+        "skip_ratio": stats["skip_ratio"],
+        "cache_hit_rate": stats["response_cache"]["hit_rate"]
+    }
+
+
+def print_report(report: dict):
+    lat = report["latency_ms"]
+    val = report["validation"]
+    tok = report["tokens_per_tick"]
+    print(f"Peticiones:     {report['requests']} en {report['wall_s']}s ({report['throughput_rps']} req/s)")
+    print(f"Latencia (ms):  p50 {lat['p50']}  p95 {lat['p95']}  p99 {lat['p99']}  máx {lat['max']}")
+    print(f"Llamadas LLM:   {report['llm_calls']}  (ticks sin cambios {report['skip_ratio']:.1%}, "
+          f"caché {report['cache_hit_rate']:.1%})")
+    print(f"Tokens/tick:    prompt {tok['prompt']}  generados {tok['eval']}")
+    print(f"Validación:     {val['rejected']}/{val['llm_commands']} órdenes rechazadas "
+          f"({val['rejection_rate']:.1%}), {val['batches_rejected']} respuestas enteras, "
+          f"{val['planner_fallbacks']} fallbacks")
+    print(f"Estados HTTP:   {report['status']}")
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Banco de pruebas offline de ReforgerAI")
+    parser.add_argument("replay", nargs="?", help="JSONL grabado con RAI_REPLAY_LOG")
+    parser.add_argument("--synthetic", type=int, default=0, help="ticks de una sesión sintética")
+    parser.add_argument("--groups", type=int, default=12, help="grupos IA de la sesión sintética")
+    parser.add_argument("--players", type=int, default=8, help="jugadores de la sesión sintética")
+    parser.add_argument("--speed", type=float, default=1.0, help="1 = tiempo real, 10 = 10x, 0 = secuencial")
+    parser.add_argument("--prefill-ms", type=float, default=0.5, help="ms por token de prompt")
+    parser.add_argument("--decode-ms", type=float, default=25.0, help="ms por token generado")
+    parser.add_argument("--jitter", type=float, default=0.2, help="ruido relativo de la latencia simulada")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--json", action="store_true", help="informe en JSON")
+    args = parser.parse_args()
+
+    if not cfg.DEBUG_MODE:
+        logging.getLogger("ReforgerAI").setLevel(logging.WARNING)
+    random.seed(args.seed)
+
+    if args.replay:
+        records = load_replay(args.replay)
+        responses = {}
+        for rec in records:
+            state, resp = rec.get("state") or {}, rec.get("response")
+            # Resultados incompletos no sirven como salida del modelo
+            if rec.get("partial"):
+                continue
+            if isinstance(resp, dict) and resp.get("commands"):
+                responses[(state.get("session_id"), state.get("tick"))] = json.dumps(
+                    {"reasoning": resp.get("reasoning", ""), "commands": resp["commands"]})
+    elif args.synthetic:
+        records, responses = synthetic_session(args.synthetic, args.groups, args.players, args.seed)
+    else:
+        parser.error("indica un fichero de replay o --synthetic N")
+
+    service = ReforgerAIService()
+    # El banco no debe grabar su propia reproducción
+    if service.recorder:
+        service.recorder.close()
+        service.recorder = None
+    MockOllama(service.llm, responses, args.prefill_ms, args.decode_ms, args.jitter).install()
+    if cfg.ASYNC_JOBS:
+        service.jobs.start()
+    try:
+        report = await run_replay(service, records, args.speed)
+    finally:
+        await service.jobs.close()
+
+    if args.json:
+        print(json.dumps(report, indent=2))
+    else:
+        print_report(report)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,161 @@
+"""
+command_executor.py — Validación compilada de órdenes antes de enviarlas al juego
+Cada tipo de comando se compila una vez al arrancar en una tupla de
+comprobaciones (parámetros obligatorios, enums, tipos, límites del mapa) y
+se cruza con los grupos y misiones del GameState del tick, para que una
+orden imposible nunca cueste un viaje de ida y vuelta al mod.
+"""
+
+import logging
+import time
+import config as cfg
+from schema import COMMAND_PARAMS
+
+log = logging.getLogger("ReforgerAI.Validator")
+
+# Comandos cuyo "target" es un group_id / mission_id del estado
+GROUP_TARGETS = {"SET_FORMATION", "SET_WAYPOINT", "SET_BEHAVIOR", "DESPAWN_GROUP", "SET_AMBUSH"}
+MISSION_TARGETS = {"UPDATE_MISSION", "END_MISSION"}
+
+_PY_TYPES = {"number": (int, float), "integer": (int,), "string": (str,)}
+
+
+class EntityIndex:
+    """Ids válidos en el tick actual."""
+    __slots__ = ("groups", "missions")
+
+    def __init__(self, gs: dict):
+        self.groups = {g.get("group_id") for g in gs.get("ai_groups", [])}
+        self.missions = {m.get("mission_id") for m in gs.get("active_missions", [])}
+
+
+class CommandValidator:
+    def __init__(self, min_coord: float = cfg.MAP_MIN_COORD, max_coord: float = cfg.MAP_MAX_COORD):
+        self.min_coord = min_coord
+        self.max_coord = max_coord
+        self._compiled = {ctype: self._compile(ctype, props, required)
+                          for ctype, (props, required) in COMMAND_PARAMS.items()}
+        self.checked = 0
+        self.rejected = {}  # motivo (sin ids) -> veces
+        self._total_us = 0.0
+
+    # ─── Compilación ────────────────────────────────────────
+    def _compile(self, ctype: str, props: dict, required: list) -> tuple:
+        checks = []
+        if ctype in GROUP_TARGETS:
+            checks.append(_known_target("groups", "grupo desconocido"))
+        elif ctype in MISSION_TARGETS:
+            checks.append(_known_target("missions", "misión desconocida"))
+
+        for name in required:
+            checks.append(_required(name))
+        for name, spec in props.items():
+            if "enum" in spec:
+                checks.append(_member(name, frozenset(spec["enum"])))
+            elif spec.get("type") == "object":
+                checks.append(_position(name, self.min_coord, self.max_coord))
+            else:
+                checks.append(_typed(name, _PY_TYPES[spec["type"]]))
+        if "assign_mission" in props:
+            checks.append(_known_mission_param("assign_mission"))
+        return tuple(checks)
+
+    # ─── Validación ─────────────────────────────────────────
+    @staticmethod
+    def entities(gs: dict) -> EntityIndex:
+        return EntityIndex(gs)
+
+    def check(self, c, ids: EntityIndex):
+        """Motivo de rechazo, o None si el comando es válido."""
+        if not isinstance(c, dict):
+            return "no es objeto"
+        checks = self._compiled.get(c.get("type"))
+        if checks is None:
+            return "tipo desconocido"
+        params = c.get("params", {})
+        if not isinstance(params, dict):
+            return "params no es objeto"
+        for check in checks:
+            reason = check(c, params, ids)
+            if reason:
+                return reason
+        return None
+
+    def accept(self, c, ids: EntityIndex, index: int = 0) -> bool:
+        t0 = time.perf_counter()
+        reason = self.check(c, ids)
+        self._total_us += (time.perf_counter() - t0) * 1e6
+        self.checked += 1
+        if reason is None:
+            return True
+        self.rejected[reason] = self.rejected.get(reason, 0) + 1
+        ctype = c.get("type") if isinstance(c, dict) else "?"
+        target = c.get("target") if isinstance(c, dict) else None
+        log.warning(f"Comando {index} ({ctype} → {target}) descartado: {reason}")
+        return False
+
+    def filter(self, commands: list, gs: dict):
+        """Devuelve (válidos, rechazados) frente al GameState del tick."""
+        ids = EntityIndex(gs)
+        valid = [c for i, c in enumerate(commands) if self.accept(c, ids, i)]
+        return valid, len(commands) - len(valid)
+
+    def stats(self) -> dict:
+        return {
+            "checked": self.checked,
+            "avg_us": round(self._total_us / max(1, self.checked), 2),
+            "rejected": dict(self.rejected),
+            "map_bounds": [self.min_coord, self.max_coord]
+        }
+
+
+# ─── Comprobaciones (cierres que se compilan por tipo) ───────
+def _known_target(kind: str, reason: str):
+    def check(c, params, ids):
+        return None if c.get("target") in getattr(ids, kind) else reason
+    return check
+
+
+def _known_mission_param(name: str):
+    def check(c, params, ids):
+        value = params.get(name)
+        return None if not value or value in ids.missions else f"{name} desconocida"
+    return check
+
+
+def _required(name: str):
+    def check(c, params, ids):
+        return None if name in params else f"falta '{name}'"
+    return check
+
+
+def _member(name: str, allowed: frozenset):
+    def check(c, params, ids):
+        return None if name not in params or params[name] in allowed else f"'{name}' inválido"
+    return check
+
+
+def _typed(name: str, types: tuple):
+    def check(c, params, ids):
+        value = params.get(name)
+        if value is None or (isinstance(value, types) and not isinstance(value, bool)):
+            return None
+        return f"'{name}' con tipo inválido"
+    return check
+
+
+def _position(name: str, lo: float, hi: float):
+    def check(c, params, ids):
+        pos = params.get(name)
+        if pos is None:
+            return None
+        if not isinstance(pos, dict):
+            return f"'{name}' no es posición"
+        for axis in ("x", "z"):
+            v = pos.get(axis)
+            if not isinstance(v, (int, float)) or isinstance(v, bool):
+                return f"'{name}' sin {axis}"
+            if not lo <= v <= hi:
+                return f"'{name}' fuera del mapa"
+        return None
+    return check
@@ -0,0 +1,261 @@
+"""
+command_stream.py — Resultados de comandos entregados por partes
+Los comandos validados se acumulan a medida que llegan y el mod los
+recoge con GET /result/<id>. En modo asíncrono cada stream es además un
+trabajo que ejecutan los workers de JobQueue. Toda inferencia pasa antes
+por InferenceGate.
+"""
+
+import asyncio
+import logging
+import time
+import uuid
+
+log = logging.getLogger("ReforgerAI.Stream")
+
+SUPERSEDED_REASONING = "Sustituido por un estado más reciente"
+
+
+class CommandStream:
+    def __init__(self, stream_id: str, session_id: str, tick):
+        self.id = stream_id
+        self.session_id = session_id
+        self.tick = tick
+        self.commands = []
+        self.delivered = 0
+        self.reasoning = ""
+        self.done = False
+        self.superseded = False
+        self.created_at = time.time()
+        self.started_at = None
+        self.task = None
+        self._changed = asyncio.Event()
+        self._finished = asyncio.Event()
+
+    def push(self, command: dict):
+        self.commands.append(command)
+        self._changed.set()
+
+    def finish(self, reasoning: str = ""):
+        if reasoning:
+            self.reasoning = reasoning
+        self.done = True
+        self._changed.set()
+        self._finished.set()
+
+    async def wait_done(self, timeout: float) -> bool:
+        """Espera a que termine; False si vence el plazo antes."""
+        try:
+            await asyncio.wait_for(self._finished.wait(), timeout)
+        except asyncio.TimeoutError:
+            pass
+        return self.done
+
+    @property
+    def drained(self) -> bool:
+        """Terminado y sin comandos pendientes de entregar."""
+        return self.done and self.delivered >= len(self.commands)
+
+    async def wait_for_new(self, timeout: float):
+        """Espera a que haya comandos sin entregar o a que termine."""
+        if self.done or self.delivered < len(self.commands):
+            return
+        self._changed.clear()
+        try:
+            await asyncio.wait_for(self._changed.wait(), timeout)
+        except asyncio.TimeoutError:
+            pass
+
+    def take_new(self) -> list:
+        new = self.commands[self.delivered:]
+        self.delivered = len(self.commands)
+        return new
+
+
+class StreamRegistry:
+    def __init__(self, ttl_s: float):
+        self.ttl_s = ttl_s
+        self._streams = {}
+
+    def create(self, session_id: str, tick) -> CommandStream:
+        self.purge_expired()
+        stream = CommandStream(uuid.uuid4().hex[:12], session_id, tick)
+        self._streams[stream.id] = stream
+        return stream
+
+    def get(self, stream_id: str):
+        return self._streams.get(stream_id)
+
+    def drop(self, stream_id: str):
+        self._streams.pop(stream_id, None)
+
+    def purge_expired(self):
+        now = time.time()
+        for sid in [s.id for s in self._streams.values() if now - s.created_at > self.ttl_s]:
+            stream = self._streams.pop(sid)
+            if stream.task and not stream.task.done():
+                stream.task.cancel()
+            log.debug(f"Stream {sid} expirado")
+
+    def __len__(self):
+        return len(self._streams)
+
+
+class JobQueue:
+    """
+    Cola de inferencias en segundo plano. Un trabajo que aún no ha empezado
+    queda sustituido en cuanto llega otro de la misma sesión: se cierra sin
+    comandos y ningún worker lo ejecuta.
+    """
+
+    def __init__(self, workers: int):
+        self.workers = workers
+        self._queue = asyncio.Queue()
+        self._waiting = {}  # session_id -> trabajo en cola sin empezar
+        self._tasks = []
+        self.superseded = 0
+
+    def start(self):
+        self._tasks = [asyncio.create_task(self._worker()) for _ in range(self.workers)]
+
+    async def close(self):
+        for t in self._tasks:
+            t.cancel()
+        await asyncio.gather(*self._tasks, return_exceptions=True)
+        self._tasks = []
+
+    def submit(self, stream: CommandStream, runner):
+        """runner: corrutina runner(stream) que produce los comandos."""
+        prev = self._waiting.get(stream.session_id)
+        if prev is not None and prev.started_at is None:
+            prev.superseded = True
+            prev.finish(SUPERSEDED_REASONING)
+            self.superseded += 1
+            log.debug(f"Trabajo {prev.id} (tick {prev.tick}) sustituido por tick {stream.tick}")
+
+        self._waiting[stream.session_id] = stream
+        self._queue.put_nowait((stream, runner))
+
+    def depth(self) -> int:
+        return self._queue.qsize()
+
+    async def _worker(self):
+        while True:
+            stream, runner = await self._queue.get()
+            try:
+                if stream.superseded:
+                    continue
+                if self._waiting.get(stream.session_id) is stream:
+                    del self._waiting[stream.session_id]
+                stream.started_at = time.time()
+                await runner(stream)
+            except asyncio.CancelledError:
+                raise
+            except Exception as e:
+                log.error(f"Error en trabajo {stream.id}: {e}", exc_info=True)
+            finally:
+                if not stream.done:
+                    stream.finish()
+                self._queue.task_done()
+
+
+class InferenceGate:
+    """
+    Turnos de inferencia: como máximo una en curso y una en espera por
+    sesión, y un límite global de inferencias simultáneas contra Ollama.
+    Un estado nuevo sustituye al que esperaba turno en su sesión.
+    """
+
+    def __init__(self, max_concurrent: int):
+        self._slots = asyncio.Semaphore(max(1, max_concurrent))
+        self._busy = set()    # sesiones con inferencia en curso o esperando hueco global
+        self._pending = {}    # session_id -> futuro del estado en espera
+        self.waiting = 0
+        self.active = 0       # huecos globales ocupados (turnos y sectores)
+        self.extra_slots = 0  # huecos adicionales concedidos a sectores
+        self.superseded = 0
+        self.avg_wait_ms = 0.0
+        self.max_wait_ms = 0.0
+        self._granted = 0
+
+    async def acquire(self, session_id: str) -> bool:
+        """Espera turno. Devuelve False si un estado más reciente lo sustituye."""
+        t0 = time.perf_counter()
+        self.waiting += 1
+        try:
+            if session_id in self._busy:
+                prev = self._pending.get(session_id)
+                if prev is not None and not prev.done():
+                    prev.set_result(False)
+                    self.superseded += 1
+                fut = asyncio.get_running_loop().create_future()
+                self._pending[session_id] = fut
+                try:
+                    if not await fut:
+                        return False
+                except asyncio.CancelledError:
+                    if self._pending.get(session_id) is fut:
+                        del self._pending[session_id]
+                    elif fut.done() and fut.result():
+                        self._handoff(session_id)
+                    raise
+            else:
+                self._busy.add(session_id)
+
+            # La sesión tiene el turno; falta hueco global
+            try:
+                await self._slots.acquire()
+            except asyncio.CancelledError:
+                self._handoff(session_id)
+                raise
+        finally:
+            self.waiting -= 1
+
+        self.active += 1
+        self._record_wait((time.perf_counter() - t0) * 1000)
+        return True
+
+    def release(self, session_id: str):
+        self.active -= 1
+        self._slots.release()
+        self._handoff(session_id)
+
+    async def acquire_slot(self):
+        """Hueco global adicional para una inferencia paralela dentro de un
+        turno ya concedido (sectores de un mismo tick)."""
+        t0 = time.perf_counter()
+        self.waiting += 1
+        try:
+            await self._slots.acquire()
+        finally:
+            self.waiting -= 1
+        self.active += 1
+        self.extra_slots += 1
+        self._record_wait((time.perf_counter() - t0) * 1000)
+
+    def release_slot(self):
+        self.active -= 1
+        self._slots.release()
+
+    def _handoff(self, session_id: str):
+        # Ceder el turno de la sesión al estado en espera, si lo hay
+        nxt = self._pending.pop(session_id, None)
+        if nxt is not None and not nxt.done():
+            nxt.set_result(True)
+        else:
+            self._busy.discard(session_id)
+
+    def _record_wait(self, ms: float):
+        self._granted += 1
+        self.avg_wait_ms += (ms - self.avg_wait_ms) / self._granted
+        self.max_wait_ms = max(self.max_wait_ms, ms)
+
+    def stats(self) -> dict:
+        return {
+            "queue_depth": self.waiting,
+            "active": self.active,
+            "extra_slots": self.extra_slots,
+            "superseded": self.superseded,
+            "avg_wait_ms": round(self.avg_wait_ms, 1),
+            "max_wait_ms": round(self.max_wait_ms, 1)
+        }
@@ -12,9 +12,114 @@ OLLAMA_URL   = os.getenv("RAI_OLLAMA_URL",   "http://localhost:11434")
 OLLAMA_MODEL = os.getenv("RAI_OLLAMA_MODEL", "mistral:7b-instruct")
 LLM_TIMEOUT  = int(os.getenv("RAI_LLM_TIMEOUT", "60"))
 
+# Modelo pequeño para ticks rutinarios (vacío = usar siempre OLLAMA_MODEL)
+OLLAMA_FAST_MODEL    = os.getenv("RAI_OLLAMA_FAST_MODEL", "")
+BIG_MODEL_INTERVAL_S = float(os.getenv("RAI_BIG_MODEL_INTERVAL_S", "60"))   # revisión estratégica
+BIG_MODEL_SLO_MS     = float(os.getenv("RAI_BIG_MODEL_SLO_MS",     "8000"))
+DEMOTION_COOLDOWN_S  = float(os.getenv("RAI_DEMOTION_COOLDOWN_S",  "120"))
+
+# Sesión HTTP persistente con Ollama
+OLLAMA_MAX_CONNECTIONS  = int(os.getenv("RAI_OLLAMA_MAX_CONNECTIONS", "4"))
+OLLAMA_KEEPALIVE_S      = int(os.getenv("RAI_OLLAMA_KEEPALIVE_S",     "60"))
+OLLAMA_HEALTH_INTERVAL  = int(os.getenv("RAI_OLLAMA_HEALTH_INTERVAL", "10"))
+
 # ── LLM Parámetros ───────────────────────────────────────────
 LLM_TEMPERATURE   = float(os.getenv("RAI_TEMPERATURE",   "0.4"))
 LLM_CONTEXT_SIZE  = int(os.getenv("RAI_CONTEXT_SIZE",    "4096"))
 
+# Mantener el modelo cargado entre ticks (formato de duración de Ollama)
+OLLAMA_KEEP_ALIVE = os.getenv("RAI_OLLAMA_KEEP_ALIVE", "30m")
+# Reutilizar el "context" devuelto por Ollama entre ticks de la misma sesión
+LLM_REUSE_CONTEXT = os.getenv("RAI_REUSE_CONTEXT", "false").lower() == "true"
+# Tokens de contexto acumulado a partir de los que se empieza de cero
+CONTEXT_REUSE_MAX_TOKENS = int(os.getenv("RAI_CONTEXT_REUSE_MAX_TOKENS", str(LLM_CONTEXT_SIZE * 3 // 4)))
+
+# Schema del AICommand como "format" de Ollama (requiere Ollama >= 0.5)
+STRUCTURED_OUTPUT = os.getenv("RAI_STRUCTURED_OUTPUT", "false").lower() == "true"
+
+# Límites del mapa para las posiciones de las órdenes (x/z, metros)
+MAP_MIN_COORD = float(os.getenv("RAI_MAP_MIN_COORD", "0"))
+MAP_MAX_COORD = float(os.getenv("RAI_MAP_MAX_COORD", "13000"))
+
+# ── Streaming de comandos ────────────────────────────────────
+# Consumir el stream de Ollama y entregar los comandos según se completan
+LLM_STREAMING       = os.getenv("RAI_STREAMING", "false").lower() == "true"
+STREAM_POLL_TIMEOUT = float(os.getenv("RAI_STREAM_POLL_TIMEOUT", "10"))   # long-poll de /result
+STREAM_TTL_S        = float(os.getenv("RAI_STREAM_TTL_S",        "120"))  # resultados sin recoger
+
+# ── Trabajos asíncronos ──────────────────────────────────────
+# /command responde 202 al instante y el mod recoge el resultado en /result/<id>
+ASYNC_JOBS  = os.getenv("RAI_ASYNC_JOBS", "false").lower() == "true"
+JOB_WORKERS = int(os.getenv("RAI_JOB_WORKERS", "1"))
+
+# Inferencias simultáneas contra Ollama (por sesión siempre una en curso
+# y una en espera; los estados intermedios se descartan)
+MAX_CONCURRENT_LLM = int(os.getenv("RAI_MAX_CONCURRENT_LLM", "1"))
+
+# ── Índice espacial ──────────────────────────────────────────
+SPATIAL_CELL_SIZE     = float(os.getenv("RAI_SPATIAL_CELL_SIZE",     "1000"))  # m, lado de sector
+SPATIAL_CLUSTER_RADIUS = float(os.getenv("RAI_SPATIAL_CLUSTER_RADIUS", "150"))  # m entre jugadores agrupados
+SPATIAL_ENGAGE_RANGE  = float(os.getenv("RAI_SPATIAL_ENGAGE_RANGE",  "1500"))  # m, distancias que se reportan
+
+# ── Inferencia por sectores ──────────────────────────────────
+# Un prompt por concentración de jugadores en paralelo (no aplica en streaming)
+SHARDING              = os.getenv("RAI_SHARDING", "false").lower() == "true"
+SHARD_MIN_GROUPS      = int(os.getenv("RAI_SHARD_MIN_GROUPS",       "12"))
+SHARD_MAX             = int(os.getenv("RAI_SHARD_MAX",              "4"))
+SHARD_WORKERS         = int(os.getenv("RAI_SHARD_WORKERS",          "2"))
+SHARD_CLUSTER_RADIUS  = float(os.getenv("RAI_SHARD_CLUSTER_RADIUS", "1500"))  # m
+SHARD_MAX_SPAWNS      = int(os.getenv("RAI_SHARD_MAX_SPAWNS",       "2"))     # por tick, entre sectores
+
+# ── Planificación en dos niveles ─────────────────────────────
+# Estrategia (misiones, intenciones) cada intervalo; táctica solo en contacto
+# (no aplica en streaming: ese modo usa siempre el prompt único)
+HIERARCHICAL          = os.getenv("RAI_HIERARCHICAL", "false").lower() == "true"
+STRATEGIC_INTERVAL_S  = float(os.getenv("RAI_STRATEGIC_INTERVAL_S", "60"))
+TIER_CONTACT_RANGE    = float(os.getenv("RAI_TIER_CONTACT_RANGE",   "800"))  # m
+TACTICAL_MAX_COMMANDS = int(os.getenv("RAI_TACTICAL_MAX_COMMANDS",  "6"))
+
+# ── Detección de cambios ─────────────────────────────────────
+# Solo consultar al LLM si el estado cambió lo suficiente desde la última vez
+CHANGE_GATE          = os.getenv("RAI_CHANGE_GATE", "false").lower() == "true"
+CHANGE_THRESHOLD     = float(os.getenv("RAI_CHANGE_THRESHOLD",     "1.0"))
+CHANGE_EVENT_WEIGHT  = float(os.getenv("RAI_CHANGE_EVENT_WEIGHT",  "1.0"))   # por evento
+CHANGE_MOVE_DISTANCE = float(os.getenv("RAI_CHANGE_MOVE_DISTANCE", "200"))   # m = 1 punto
+CHANGE_HEALTH_DELTA  = float(os.getenv("RAI_CHANGE_HEALTH_DELTA",  "20"))    # salud = 1 punto
+CHANGE_MAX_IDLE_S    = float(os.getenv("RAI_CHANGE_MAX_IDLE_S",    "30"))    # consulta forzada
+
+# ── Caché de respuestas ──────────────────────────────────────
+# Reutilizar la última respuesta validada para situaciones equivalentes
+RESPONSE_CACHE       = os.getenv("RAI_RESPONSE_CACHE", "false").lower() == "true"
+CACHE_SIZE           = int(os.getenv("RAI_CACHE_SIZE",             "256"))
+CACHE_TTL_S          = float(os.getenv("RAI_CACHE_TTL_S",          "60"))
+CACHE_CELL_SIZE      = float(os.getenv("RAI_CACHE_CELL_SIZE",      "250"))  # m
+CACHE_HEALTH_BUCKET  = float(os.getenv("RAI_CACHE_HEALTH_BUCKET",  "25"))
+# Similitud mínima (Jaccard de rasgos) para reutilizar; 1.0 = solo idénticas
+CACHE_SIMILARITY     = float(os.getenv("RAI_CACHE_SIMILARITY",     "1.0"))
+
+# ── Planificador por reglas ──────────────────────────────────
+# Responder los ticks sin eventos relevantes sin consultar al LLM
+PLANNER_FAST_PATH        = os.getenv("RAI_PLANNER_FAST_PATH", "false").lower() == "true"
+PLANNER_CONTACT_RANGE    = float(os.getenv("RAI_PLANNER_CONTACT_RANGE",    "400"))  # m
+PLANNER_RETREAT_HEALTH   = float(os.getenv("RAI_PLANNER_RETREAT_HEALTH",   "40"))
+PLANNER_RETREAT_DISTANCE = float(os.getenv("RAI_PLANNER_RETREAT_DISTANCE", "300"))  # m
+PLANNER_MAX_COMMANDS     = int(os.getenv("RAI_PLANNER_MAX_COMMANDS",       "8"))
+PLANNER_WAYPOINT_TOLERANCE = float(os.getenv("RAI_PLANNER_WAYPOINT_TOLERANCE", "50"))  # m
+
+# ── Compresión del estado ────────────────────────────────────
+# Tokens reservados para el GameState dentro de num_ctx (el resto es
+# prompt de sistema y respuesta)
+STATE_TOKEN_BUDGET    = int(os.getenv("RAI_STATE_TOKEN_BUDGET",    "2400"))
+COMPRESS_NEAR_DISTANCE = float(os.getenv("RAI_COMPRESS_NEAR_DISTANCE", "800"))  # m
+COMPRESS_MAX_EVENTS   = int(os.getenv("RAI_COMPRESS_MAX_EVENTS",   "10"))
+
+# ── Protocolo delta ──────────────────────────────────────────
+# Snapshots completos que se guardan por sesión para reconstruir deltas
+DELTA_HISTORY = int(os.getenv("RAI_DELTA_HISTORY", "16"))
+
+# ── Grabación de sesiones ────────────────────────────────────
+# Ruta del JSONL de replay (vacío = no grabar); se reproduce con bench.py
+REPLAY_LOG = os.getenv("RAI_REPLAY_LOG", "")
+
 # ── Debug ────────────────────────────────────────────────────
 DEBUG_MODE = os.getenv("RAI_DEBUG", "false").lower() == "true"
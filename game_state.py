@@ -2,36 +2,362 @@
 game_state.py — Procesa y enriquece el GameState antes de enviarlo al LLM
 """
 
-import json
 import logging
+import math
+import time
+from collections import OrderedDict
+import config as cfg
+from state_compressor import StateCompressor
 
 log = logging.getLogger("ReforgerAI.State")
 
+# Secciones con entidades identificables y su campo id
+DELTA_SECTIONS = {
+    "players": "id",
+    "ai_groups": "group_id",
+    "active_missions": "mission_id",
+}
+
+# Máximo de sesiones simultáneas con historial delta
+MAX_DELTA_SESSIONS = 32
+
+
+class StateReconstructor:
+    """
+    Reconstruye el GameState completo a partir de un snapshot base y los
+    deltas enviados por el mod (entidades añadidas/cambiadas y eliminadas).
+    """
+
+    def __init__(self, history: int = cfg.DELTA_HISTORY):
+        self.history = history
+        self._sessions = OrderedDict()  # session_id -> OrderedDict[tick -> secciones]
+
+    def reconstruct(self, gs: dict):
+        """
+        Devuelve el estado completo, o None si el delta referencia una base
+        que ya no está en el historial (el mod debe reenviar un keyframe).
+        """
+        session = self._session(gs["session_id"])
+
+        if gs.get("delta"):
+            base = session.get(gs.get("base_tick"))
+            if base is None:
+                log.warning(f"Base delta {gs.get('base_tick')} desconocida "
+                            f"({gs['session_id']}), solicitando keyframe")
+                return None
+
+            full = {k: v for k, v in gs.items() if k not in ("delta", "base_tick", "removed")}
+            removed = gs.get("removed", {})
+            for section, key in DELTA_SECTIONS.items():
+                merged = {e.get(key): e for e in base[section]}
+                for r in removed.get(section, []):
+                    merged.pop(r.get("id") if isinstance(r, dict) else r, None)
+                for e in gs.get(section, []):
+                    merged[e.get(key)] = e
+                full[section] = list(merged.values())
+        else:
+            full = gs
+
+        session[gs["tick"]] = {s: full.get(s, []) for s in DELTA_SECTIONS}
+        while len(session) > self.history:
+            session.popitem(last=False)
+        return full
+
+    def _session(self, session_id: str) -> OrderedDict:
+        session = self._sessions.get(session_id)
+        if session is None:
+            session = self._sessions[session_id] = OrderedDict()
+            if len(self._sessions) > MAX_DELTA_SESSIONS:
+                self._sessions.popitem(last=False)
+        else:
+            self._sessions.move_to_end(session_id)
+        return session
+
+
+class SpatialGrid:
+    """
+    Rejilla uniforme de sectores con jugadores y grupos IA, reconstruida en
+    cada tick. Las búsquedas de vecinos solo recorren las celdas cercanas.
+    """
+
+    def __init__(self, cell_size: float = cfg.SPATIAL_CELL_SIZE):
+        self.cell_size = cell_size
+        self._cells = {}  # (cx, cz) -> {"players": [...], "groups": [...]}
+        self._bounds = None
+
+    @classmethod
+    def from_state(cls, gs: dict, cell_size: float = cfg.SPATIAL_CELL_SIZE) -> "SpatialGrid":
+        grid = cls(cell_size)
+        for p in gs.get("players", []):
+            grid.insert("players", p)
+        for g in gs.get("ai_groups", []):
+            grid.insert("groups", g)
+        return grid
+
+    def cell_of(self, pos: dict) -> tuple:
+        return int(pos["x"] // self.cell_size), int(pos["z"] // self.cell_size)
+
+    @staticmethod
+    def key(cell: tuple) -> str:
+        return f"{cell[0]}_{cell[1]}"
+
+    def insert(self, kind: str, item: dict):
+        pos = item.get("position")
+        if not isinstance(pos, dict) or "x" not in pos or "z" not in pos:
+            return
+        cell = self.cell_of(pos)
+        self._cells.setdefault(cell, {"players": [], "groups": []})[kind].append(item)
+        if self._bounds is None:
+            self._bounds = [cell[0], cell[1], cell[0], cell[1]]
+        else:
+            b = self._bounds
+            b[0], b[1] = min(b[0], cell[0]), min(b[1], cell[1])
+            b[2], b[3] = max(b[2], cell[0]), max(b[3], cell[1])
+
+    def cells(self):
+        return self._cells.items()
+
+    def nearest(self, pos: dict, kind: str, accept=None, max_dist: float = math.inf):
+        """(distancia, elemento) más cercano de ese tipo, o (inf, None)."""
+        if self._bounds is None:
+            return math.inf, None
+        cx, cz = self.cell_of(pos)
+        b = self._bounds
+        max_ring = max(cx - b[0], b[2] - cx, cz - b[1], b[3] - cz)
+        if max_dist != math.inf:
+            max_ring = min(max_ring, int(max_dist // self.cell_size) + 1)
+
+        best, best_item = math.inf, None
+        for r in range(max_ring + 1):
+            # Las celdas del anillo r están a más de (r - 1) * lado
+            if best <= (r - 1) * self.cell_size:
+                break
+            for cell in self._ring(cx, cz, r):
+                bucket = self._cells.get(cell)
+                if not bucket:
+                    continue
+                for item in bucket[kind]:
+                    if accept and not accept(item):
+                        continue
+                    p = item["position"]
+                    d = math.hypot(p["x"] - pos["x"], p["z"] - pos["z"])
+                    if d < best:
+                        best, best_item = d, item
+        if best > max_dist:
+            return math.inf, None
+        return best, best_item
+
+    def within(self, pos: dict, kind: str, radius: float):
+        """Elementos de ese tipo a menos de radius."""
+        cx, cz = self.cell_of(pos)
+        reach = int(math.ceil(radius / self.cell_size))
+        for dx in range(-reach, reach + 1):
+            for dz in range(-reach, reach + 1):
+                bucket = self._cells.get((cx + dx, cz + dz))
+                if not bucket:
+                    continue
+                for item in bucket[kind]:
+                    p = item["position"]
+                    if math.hypot(p["x"] - pos["x"], p["z"] - pos["z"]) <= radius:
+                        yield item
+
+    def player_clusters(self, radius: float) -> list:
+        """Jugadores vivos a menos de radius encadenados en grupos, de mayor a menor."""
+        players = [p for bucket in self._cells.values() for p in bucket["players"]
+                   if _alive(p) and "id" in p]
+        parent = {p["id"]: p["id"] for p in players}
+
+        def find(i):
+            while parent[i] != i:
+                parent[i] = parent[parent[i]]
+                i = parent[i]
+            return i
+
+        for p in players:
+            for q in self.within(p["position"], "players", radius):
+                if q.get("id") in parent:
+                    parent[find(q["id"])] = find(p["id"])
+
+        by_root = {}
+        for p in players:
+            by_root.setdefault(find(p["id"]), []).append(p)
+
+        clusters = []
+        for members in by_root.values():
+            n = len(members)
+            clusters.append({
+                "size": n,
+                "center": {
+                    "x": round(sum(m["position"]["x"] for m in members) / n),
+                    "z": round(sum(m["position"]["z"] for m in members) / n)
+                },
+                "players": [m["id"] for m in members]
+            })
+        clusters.sort(key=lambda c: (-c["size"], c["players"][0]))
+        return clusters
+
+    @staticmethod
+    def _ring(cx: int, cz: int, r: int):
+        if r == 0:
+            yield cx, cz
+            return
+        for d in range(-r, r + 1):
+            yield cx + d, cz - r
+            yield cx + d, cz + r
+        for d in range(-r + 1, r):
+            yield cx - r, cz + d
+            yield cx + r, cz + d
+
+
+def _alive(p: dict) -> bool:
+    return p.get("alive", True)
+
+
+def _unit_count(g: dict) -> int:
+    units = g.get("units")
+    return len(units) if isinstance(units, list) else g.get("unit_count", 0)
+
 
 class GameStateProcessor:
     def __init__(self):
-        self.previous_state = None
+        # session_id -> {"state": último estado de referencia, "processed_at": última consulta al LLM}
+        self._history = OrderedDict()
         self.tick_history = []
+        self.reconstructor = StateReconstructor()
+        self.compressor = StateCompressor()
 
-    def process(self, game_state: dict) -> str:
+    def reconstruct(self, game_state: dict):
+        """Expande un GameState delta a estado completo (None si falta la base)."""
+        return self.reconstructor.reconstruct(game_state)
+
+    def process(self, game_state: dict, remember: bool = True) -> str:
         """
         Recibe el GameState crudo, lo enriquece con contexto adicional
-        y devuelve el JSON string listo para el LLM.
+        y devuelve el JSON string listo para el LLM, ajustado al
+        presupuesto de tokens. Con remember=False (sectores de un mismo
+        tick) no se actualiza el estado de referencia de la sesión.
         """
         enriched = dict(game_state)
+        # Telemetría del mod, no aporta al LLM
+        enriched.pop("mod_stats", None)
+        enriched.pop("event_stats", None)
 
         # Calcular métricas derivadas
-        enriched["_meta"] = self._compute_meta(game_state)
+        grid = SpatialGrid.from_state(game_state)
+        enriched["_meta"] = self._compute_meta(game_state, grid)
 
         # Guardar historial reducido (últimos 3 ticks para contexto)
-        if self.previous_state:
-            enriched["_previous_tick_summary"] = self._summarize(self.previous_state)
+        prev = self.previous_state(game_state["session_id"])
+        if prev:
+            enriched["_previous_tick_summary"] = self._summarize(prev)
+
+        if remember:
+            self.remember(game_state)
+
+        return self.compressor.compress(enriched, grid)
+
+    def remember(self, game_state: dict, consulted: bool = True):
+        """
+        Toma game_state como referencia para significance(). Con
+        consulted=False (tick resuelto por el planificador) no se reinicia
+        el plazo de CHANGE_MAX_IDLE_S: el LLM sigue revisando la situación
+        al menos con esa frecuencia.
+        """
+        entry = self._session(game_state["session_id"])
+        entry["state"] = game_state
+        if consulted:
+            entry["processed_at"] = time.monotonic()
 
-        self.previous_state = game_state
+    def previous_state(self, session_id: str):
+        entry = self._history.get(session_id)
+        return entry["state"] if entry else None
 
-        return json.dumps(enriched, ensure_ascii=False)
+    def _session(self, session_id: str) -> dict:
+        entry = self._history.get(session_id)
+        if entry is None:
+            entry = self._history[session_id] = {"state": None, "processed_at": 0.0}
+            if len(self._history) > MAX_DELTA_SESSIONS:
+                self._history.popitem(last=False)
+        else:
+            self._history.move_to_end(session_id)
+        return entry
 
-    def _compute_meta(self, gs: dict) -> dict:
+    def significance(self, gs: dict):
+        """
+        Puntúa cuánto ha cambiado el estado desde el último de referencia
+        de la misma sesión. Devuelve (puntuación, motivos); a partir de
+        cfg.CHANGE_THRESHOLD merece la pena consultar al modelo.
+        """
+        entry = self._history.get(gs["session_id"])
+        prev = entry["state"] if entry else None
+        if prev is None:
+            return math.inf, ["primer estado"]
+        if gs.get("urgent"):
+            return math.inf, ["urgente"]
+        if time.monotonic() - entry["processed_at"] >= cfg.CHANGE_MAX_IDLE_S:
+            return math.inf, ["intervalo máximo sin consultar"]
+
+        score, reasons = 0.0, []
+
+        events = gs.get("events", [])
+        if events:
+            score += len(events) * cfg.CHANGE_EVENT_WEIGHT
+            reasons.append(f"{len(events)} eventos")
+
+        # Jugadores: altas/bajas, muertes y desplazamiento máximo
+        prev_players = {p.get("id"): p for p in prev.get("players", [])}
+        moved = 0.0
+        for p in gs.get("players", []):
+            old = prev_players.pop(p.get("id"), None)
+            if old is None or _alive(old) != _alive(p):
+                score += 1
+                reasons.append(f"jugador {p.get('id')}")
+                continue
+            moved = max(moved, self._displacement(old.get("position"), p.get("position")))
+        if prev_players:
+            score += len(prev_players)
+            reasons.append(f"{len(prev_players)} jugadores fuera")
+        if moved >= cfg.CHANGE_MOVE_DISTANCE / 2:
+            score += moved / cfg.CHANGE_MOVE_DISTANCE
+            reasons.append(f"movimiento {moved:.0f}m")
+
+        # Grupos: altas/bajas y variación de salud
+        prev_groups = {g.get("group_id"): g for g in prev.get("ai_groups", [])}
+        for g in gs.get("ai_groups", []):
+            old = prev_groups.pop(g.get("group_id"), None)
+            if old is None:
+                score += 1
+                reasons.append(f"grupo {g.get('group_id')}")
+                continue
+            dh = abs(g.get("health_avg", 100) - old.get("health_avg", 100))
+            if dh > 0:
+                score += dh / cfg.CHANGE_HEALTH_DELTA
+                if dh >= cfg.CHANGE_HEALTH_DELTA:
+                    reasons.append(f"salud {g.get('group_id')} {dh:+.0f}")
+        if prev_groups:
+            score += len(prev_groups)
+            reasons.append(f"{len(prev_groups)} grupos eliminados")
+
+        # Misiones: nuevas, terminadas o con cambio de estado
+        prev_missions = {m.get("mission_id"): m for m in prev.get("active_missions", [])}
+        for m in gs.get("active_missions", []):
+            old = prev_missions.pop(m.get("mission_id"), None)
+            if old is None or old.get("status") != m.get("status"):
+                score += 1
+                reasons.append(f"misión {m.get('mission_id')}")
+        if prev_missions:
+            score += len(prev_missions)
+            reasons.append(f"{len(prev_missions)} misiones cerradas")
+
+        return score, reasons
+
+    @staticmethod
+    def _displacement(a, b) -> float:
+        if not isinstance(a, dict) or not isinstance(b, dict):
+            return 0.0
+        return math.hypot(b.get("x", 0) - a.get("x", 0), b.get("z", 0) - a.get("z", 0))
+
+    def _compute_meta(self, gs: dict, grid: SpatialGrid) -> dict:
         """Calcula métricas útiles para el LLM."""
         players = gs.get("players", [])
         alive_players = [p for p in players if p.get("alive", True)]
@@ -45,10 +371,45 @@ class GameStateProcessor:
             "recent_event_count": len(events),
             "threat_events": [e["type"] for e in events if e.get("type") in
                               {"CONTACT_SPOTTED", "PLAYER_DOWNED", "OBJECTIVE_CAPTURED"}],
-            "pressure_level": self._compute_pressure(gs)
+            "pressure_level": self.pressure_level(gs),
+            "sectors": self._sector_summary(grid),
+            "nearest_enemy_m": self._nearest_enemies(ai_groups, grid),
+            "player_clusters": grid.player_clusters(cfg.SPATIAL_CLUSTER_RADIUS)
         }
 
-    def _compute_pressure(self, gs: dict) -> str:
+    def _sector_summary(self, grid: SpatialGrid) -> list:
+        """Fuerzas por sector ocupado; force_ratio = unidades IA / jugadores vivos."""
+        out = []
+        for cell, bucket in grid.cells():
+            players = sum(1 for p in bucket["players"] if _alive(p))
+            ai_units = sum(_unit_count(g) for g in bucket["groups"])
+            out.append({
+                "sector": grid.key(cell),
+                "players": players,
+                "ai_groups": len(bucket["groups"]),
+                "ai_units": ai_units,
+                "force_ratio": round(ai_units / players, 2) if players else None
+            })
+        out.sort(key=lambda s: (-s["players"], -s["ai_units"]))
+        return out
+
+    def _nearest_enemies(self, ai_groups: list, grid: SpatialGrid) -> dict:
+        """Distancia de cada grupo al jugador enemigo vivo más cercano (solo
+        los que están dentro del alcance de enfrentamiento)."""
+        out = {}
+        for g in ai_groups:
+            pos = g.get("position")
+            if not isinstance(pos, dict):
+                continue
+            faction = g.get("faction")
+            dist, _ = grid.nearest(pos, "players",
+                                   accept=lambda p: _alive(p) and p.get("faction") != faction,
+                                   max_dist=cfg.SPATIAL_ENGAGE_RANGE)
+            if dist != math.inf:
+                out[g.get("group_id")] = round(dist)
+        return out
+
+    def pressure_level(self, gs: dict) -> str:
         """Estima la presión táctica actual sobre los jugadores."""
         players = gs.get("players", [])
         alive = sum(1 for p in players if p.get("alive", True))
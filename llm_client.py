@@ -3,11 +3,15 @@ llm_client.py — Cliente para Ollama
 Gestiona la comunicación con el LLM local
 """
 
+import asyncio
 import json
 import logging
+import re
 import time
 import aiohttp
 import config as cfg
+from schema import POSITION_SCHEMA, ai_command_schema
+from strategic_planner import STRATEGIC_COMMANDS, TACTICAL_COMMANDS, VALID_INTENTS
 
 log = logging.getLogger("ReforgerAI.LLM")
 
@@ -38,6 +42,157 @@ FORMACIONES: LINE, COLUMN, WEDGE, SKIRMISHER, VEE, ECHELON_LEFT, ECHELON_RIGHT
 COMPORTAMIENTOS: SAFE, AWARE, COMBAT, STEALTH
 WAPOINTS/BEHAVIOR: PATROL, ASSAULT, DEFEND, RETREAT, FLANK"""
 
+# Planificación en dos niveles (RAI_HIERARCHICAL): el nivel estratégico
+# decide misiones, refuerzos e intenciones por grupo con poca frecuencia
+STRATEGIC_SYSTEM_PROMPT = """Eres el mando estratégico de IA para una partida de Arma Reforger en modo Game Master.
+Decides cada minuto, o cuando cambian las misiones, qué debe conseguir cada grupo OPFOR/INDFOR.
+Otro nivel táctico se encarga de formaciones y comportamientos en combate: no los emitas.
+
+RESTRICCIONES ABSOLUTAS:
+- Responde SOLO con JSON válido, sin texto extra, sin markdown
+- No inventes posiciones que no estén en el GameState
+- "intents" asigna a cada grupo: {"intent": ATTACK|DEFEND|PATROL|FLANK|AMBUSH|RESERVE,
+  "objective": {"x","y","z"}, "mission_id": opcional}
+
+COMANDOS PERMITIDOS:
+CREATE_MISSION, UPDATE_MISSION, END_MISSION, CALL_REINFORCEMENTS, SPAWN_GROUP,
+DESPAWN_GROUP, BROADCAST_MESSAGE, TRIGGER_EVENT, SET_WAYPOINT (solo grupos sin contacto)
+
+WAPOINTS/BEHAVIOR: PATROL, ASSAULT, DEFEND, RETREAT, FLANK"""
+
+# El nivel táctico recibe solo los grupos en contacto y su intención
+TACTICAL_SYSTEM_PROMPT = """Eres el jefe táctico de IA para una partida de Arma Reforger.
+Recibes solo los grupos en contacto con jugadores, cada uno con la intención ("intent")
+que le ha fijado el mando estratégico. Emite pocas órdenes, concretas y coherentes con ella.
+
+RESTRICCIONES ABSOLUTAS:
+- Responde SOLO con JSON válido, sin texto extra, sin markdown
+- Ordena solo a los grupos del estado; "reasoning" en una frase
+
+COMANDOS PERMITIDOS: SET_FORMATION, SET_WAYPOINT, SET_BEHAVIOR, SET_AMBUSH, VEHICLE_ORDER
+
+FORMACIONES: LINE, COLUMN, WEDGE, SKIRMISHER, VEE, ECHELON_LEFT, ECHELON_RIGHT
+COMPORTAMIENTOS: SAFE, AWARE, COMBAT, STEALTH
+WAPOINTS/BEHAVIOR: PATROL, ASSAULT, DEFEND, RETREAT, FLANK"""
+
+# Parte fija del mensaje de usuario. Todo lo que precede al estado debe ser
+# idéntico byte a byte entre llamadas para que Ollama reaproveche la caché KV.
+USER_PREFIX = (
+    "Analiza este estado del campo de batalla y emite órdenes tácticas.\n"
+    "Responde SOLO con el JSON de AICommand:\n\n"
+)
+
+# Nivel → (prompt de sistema, prefijo del mensaje de usuario)
+PROMPTS = {
+    "full": (SYSTEM_PROMPT, USER_PREFIX),
+    "strategic": (STRATEGIC_SYSTEM_PROMPT, (
+        "Revisa la situación general y fija misiones e intenciones.\n"
+        "Responde SOLO con el JSON de AICommand más \"intents\":\n\n"
+    )),
+    "tactical": (TACTICAL_SYSTEM_PROMPT, (
+        "Grupos en contacto y su intención. Emite las órdenes tácticas.\n"
+        "Responde SOLO con el JSON de AICommand:\n\n"
+    )),
+}
+
+# Salida estructurada (RAI_STRUCTURED_OUTPUT): schema por nivel, construido una vez
+_INTENTS_SCHEMA = {
+    "type": "object",
+    "additionalProperties": {
+        "type": "object",
+        "properties": {
+            "intent": {"type": "string", "enum": sorted(VALID_INTENTS)},
+            "objective": POSITION_SCHEMA,
+            "mission_id": {"type": "string"}
+        },
+        "required": ["intent"]
+    }
+}
+SCHEMAS = {
+    "full": ai_command_schema(),
+    "strategic": ai_command_schema(STRATEGIC_COMMANDS, {"intents": _INTENTS_SCHEMA}),
+    "tactical": ai_command_schema(TACTICAL_COMMANDS),
+}
+
+# Sesiones con contexto de Ollama guardado
+MAX_CONTEXT_SESSIONS = 32
+
+
+def strip_markdown(content: str) -> str:
+    """Limpia posibles bloques markdown si el modelo los añade."""
+    content = content.strip()
+    if content.startswith("```"):
+        lines = content.split("\n")
+        content = "\n".join(lines[1:-1])
+    return content
+
+
+class IncrementalCommandParser:
+    """
+    Extrae los elementos del array "commands" a medida que llega el texto
+    del modelo, sin esperar a que el JSON completo esté cerrado.
+    """
+
+    _COMMANDS_RE = re.compile(r'"commands"\s*:\s*\[')
+
+    def __init__(self):
+        self.buffer = ""
+        self._pos = 0
+        self._in_array = False
+        self._done = False
+        self._depth = 0
+        self._in_string = False
+        self._escape = False
+        self._start = None
+
+    def feed(self, text: str) -> list:
+        """Añade texto y devuelve los comandos completados con él."""
+        self.buffer += text
+        if self._done:
+            return []
+
+        if not self._in_array:
+            m = self._COMMANDS_RE.search(self.buffer)
+            if not m:
+                return []
+            self._in_array = True
+            self._pos = m.end()
+
+        out = []
+        buf = self.buffer
+        i = self._pos
+        while i < len(buf):
+            ch = buf[i]
+            if self._in_string:
+                if self._escape:
+                    self._escape = False
+                elif ch == "\\":
+                    self._escape = True
+                elif ch == '"':
+                    self._in_string = False
+            elif ch == '"':
+                self._in_string = True
+            elif ch in "{[":
+                if self._depth == 0:
+                    self._start = i
+                self._depth += 1
+            elif ch in "}]":
+                if self._depth == 0:
+                    # Cierre del array de comandos
+                    self._done = True
+                    i += 1
+                    break
+                self._depth -= 1
+                if self._depth == 0 and self._start is not None:
+                    try:
+                        out.append(json.loads(buf[self._start:i + 1]))
+                    except ValueError:
+                        log.warning("Comando con JSON inválido en el stream, ignorado")
+                    self._start = None
+            i += 1
+        self._pos = i
+        return out
+
 
 class OllamaClient:
     def __init__(self, base_url: str, model: str, timeout: int = 60):
@@ -45,35 +200,112 @@ class OllamaClient:
         self.model = model
         self.timeout = aiohttp.ClientTimeout(total=timeout)
         self._conversation_history = []
+        self._session = None
+        self._health_session = None
+        self._health_task = None
+        self._contexts = {}  # (modelo, session_id) -> tokens de "context" del último tick
+        self.timing = {
+            "calls": 0,
+            "prompt_eval_tokens": 0,
+            "prompt_eval_ms": 0.0,
+            "eval_tokens": 0,
+            "eval_ms": 0.0,
+            "load_ms": 0.0,
+            "context_reused": 0,
+            "context_resets": 0,
+            "by_prompt": {},  # nivel -> [llamadas, tokens de prompt, tokens generados]
+            "last": {}
+        }
+        # Estado de Ollama refrescado en segundo plano (para /health)
+        self.reachable = False
+        self.last_health_check = 0.0
+
+    async def start(self):
+        """Abre la sesión persistente y arranca la comprobación periódica."""
+        self._get_session()
+        if await self.refresh_health():
+            await self.preload()
+        self._health_task = asyncio.create_task(self._health_loop())
+
+    async def close(self):
+        if self._health_task:
+            self._health_task.cancel()
+            try:
+                await self._health_task
+            except asyncio.CancelledError:
+                pass
+            self._health_task = None
+        if self._session:
+            await self._session.close()
+            self._session = None
+        if self._health_session:
+            await self._health_session.close()
+            self._health_session = None
+
+    def _get_session(self) -> aiohttp.ClientSession:
+        # Una única sesión con keep-alive y pool de conexiones acotado
+        if self._session is None or self._session.closed:
+            connector = aiohttp.TCPConnector(
+                limit=cfg.OLLAMA_MAX_CONNECTIONS,
+                keepalive_timeout=cfg.OLLAMA_KEEPALIVE_S
+            )
+            self._session = aiohttp.ClientSession(connector=connector, timeout=self.timeout)
+        return self._session
+
+    def _get_health_session(self) -> aiohttp.ClientSession:
+        # Conexión propia: el sondeo no espera a que se libere el pool de
+        # inferencia y no informa "degraded" con Ollama ocupado
+        if self._health_session is None or self._health_session.closed:
+            self._health_session = aiohttp.ClientSession(
+                connector=aiohttp.TCPConnector(limit=1, keepalive_timeout=cfg.OLLAMA_KEEPALIVE_S),
+                timeout=aiohttp.ClientTimeout(total=5)
+            )
+        return self._health_session
 
     async def ping(self) -> bool:
         try:
-            async with aiohttp.ClientSession(timeout=aiohttp.ClientTimeout(total=5)) as session:
-                async with session.get(f"{self.base_url}/api/tags") as resp:
-                    return resp.status == 200
+            async with self._get_health_session().get(f"{self.base_url}/api/tags") as resp:
+                return resp.status == 200
         except Exception:
             return False
 
-    async def generate(self, game_state_json: str) -> str:
-        """Envía el estado del juego al LLM y devuelve el JSON de comandos."""
-
-        messages = [
-            {"role": "system", "content": SYSTEM_PROMPT},
-            {
-                "role": "user",
-                "content": (
-                    "Analiza este estado del campo de batalla y emite órdenes tácticas.\n"
-                    "Responde SOLO con el JSON de AICommand:\n\n"
-                    f"```json\n{game_state_json}\n```"
-                )
-            }
-        ]
+    async def refresh_health(self) -> bool:
+        self.reachable = await self.ping()
+        self.last_health_check = time.time()
+        return self.reachable
 
+    async def _health_loop(self):
+        while True:
+            await asyncio.sleep(cfg.OLLAMA_HEALTH_INTERVAL)
+            was_reachable = self.reachable
+            if await self.refresh_health() != was_reachable:
+                log.info(f"Ollama {'disponible' if self.reachable else 'no responde'}")
+
+    async def preload(self, model: str = None):
+        """Carga el modelo en memoria sin generar nada."""
+        model = model or self.model
+        try:
+            async with self._get_session().post(
+                f"{self.base_url}/api/generate",
+                json={"model": model, "keep_alive": cfg.OLLAMA_KEEP_ALIVE}
+            ) as resp:
+                if resp.status == 200:
+                    data = await resp.json()
+                    log.info(f"Modelo {model} cargado en {data.get('load_duration', 0) / 1e6:.0f}ms")
+        except Exception as e:
+            log.warning(f"No se pudo precargar el modelo {model}: {e}")
+
+    def _build_payload(self, game_state_json: str, stream: bool, context_key=None, model: str = None,
+                       tier: str = "full"):
+        """Devuelve (endpoint, payload). Con contexto reutilizable se usa
+        /api/generate, que es el único que devuelve "context"."""
+        system_prompt, user_prefix = PROMPTS[tier]
+        prompt = f"{user_prefix}```json\n{game_state_json}\n```"
         payload = {
-            "model": self.model,
-            "messages": messages,
-            "stream": False,
-            "format": "json",
+            "model": model or self.model,
+            "stream": stream,
+            "format": SCHEMAS[tier] if cfg.STRUCTURED_OUTPUT else "json",
+            "keep_alive": cfg.OLLAMA_KEEP_ALIVE,
             "options": {
                 "temperature": cfg.LLM_TEMPERATURE,
                 "top_p": 0.9,
@@ -81,31 +313,156 @@ class OllamaClient:
             }
         }
 
+        if cfg.LLM_REUSE_CONTEXT and context_key:
+            payload["prompt"] = prompt
+            context = self._contexts.get(context_key)
+            if context:
+                # El contexto ya empieza por el prompt de sistema: repetirlo
+                # haría que Ollama lo plantillara otra vez detrás del historial
+                payload["context"] = context
+                self.timing["context_reused"] += 1
+            else:
+                payload["system"] = system_prompt
+            return "/api/generate", payload
+
+        payload["messages"] = [
+            {"role": "system", "content": system_prompt},
+            {"role": "user", "content": prompt}
+        ]
+        return "/api/chat", payload
+
+    @staticmethod
+    def _content(chunk: dict) -> str:
+        # /api/chat devuelve "message", /api/generate devuelve "response"
+        if "message" in chunk:
+            return chunk["message"].get("content", "")
+        return chunk.get("response", "")
+
+    def _context_key(self, session_id: str, model: str, tier: str = "full"):
+        # El contexto solo sirve para el modelo y el prompt que lo generaron
+        return (model or self.model, tier, session_id) if session_id else None
+
+    def _record_timing(self, data: dict, context_key=None, tier: str = "full"):
+        """Métricas de la respuesta final de Ollama (duraciones en ns)."""
+        last = {
+            "prompt_eval_tokens": data.get("prompt_eval_count", 0),
+            "prompt_eval_ms": data.get("prompt_eval_duration", 0) / 1e6,
+            "eval_tokens": data.get("eval_count", 0),
+            "eval_ms": data.get("eval_duration", 0) / 1e6,
+            "load_ms": data.get("load_duration", 0) / 1e6
+        }
+        t = self.timing
+        t["calls"] += 1
+        for key, value in last.items():
+            t[key] += value
+        t["last"] = last
+        per = t["by_prompt"].setdefault(tier, [0, 0, 0])
+        per[0] += 1
+        per[1] += last["prompt_eval_tokens"]
+        per[2] += last["eval_tokens"]
+        log.debug(f"Prompt: {last['prompt_eval_tokens']} tokens en {last['prompt_eval_ms']:.0f}ms")
+
+        if context_key and "context" in data:
+            self._store_context(context_key, data["context"])
+
+    def _store_context(self, context_key, context: list):
+        # Un contexto demasiado largo dejaría sin hueco al estado siguiente
+        if len(context) > cfg.CONTEXT_REUSE_MAX_TOKENS:
+            self._contexts.pop(context_key, None)
+            self.timing["context_resets"] += 1
+            return
+        self._contexts.pop(context_key, None)
+        self._contexts[context_key] = context
+        while len(self._contexts) > MAX_CONTEXT_SESSIONS:
+            self._contexts.pop(next(iter(self._contexts)))
+
+    def timing_stats(self) -> dict:
+        t = self.timing
+        n = max(1, t["calls"])
+        return {
+            "calls": t["calls"],
+            "avg_prompt_eval_tokens": round(t["prompt_eval_tokens"] / n, 1),
+            "avg_prompt_eval_ms": round(t["prompt_eval_ms"] / n, 1),
+            "avg_eval_tokens": round(t["eval_tokens"] / n, 1),
+            "avg_eval_ms": round(t["eval_ms"] / n, 1),
+            "load_ms_total": round(t["load_ms"], 1),
+            "context_reused": t["context_reused"],
+            "context_resets": t["context_resets"],
+            "by_prompt": {
+                tier: {
+                    "calls": calls,
+                    "avg_prompt_eval_tokens": round(prompt_tokens / calls, 1),
+                    "avg_eval_tokens": round(eval_tokens / calls, 1)
+                }
+                for tier, (calls, prompt_tokens, eval_tokens) in t["by_prompt"].items()
+            },
+            "last": t["last"]
+        }
+
+    async def generate(self, game_state_json: str, session_id: str = None, model: str = None,
+                       tier: str = "full") -> str:
+        """Envía el estado del juego al LLM y devuelve el JSON de comandos.
+        tier elige el prompt: "full", "strategic" o "tactical"."""
+        context_key = self._context_key(session_id, model, tier)
+        endpoint, payload = self._build_payload(game_state_json, False, context_key, model, tier)
+
         t0 = time.perf_counter()
-        async with aiohttp.ClientSession(timeout=self.timeout) as session:
-            async with session.post(
-                f"{self.base_url}/api/chat",
-                json=payload
-            ) as resp:
-                if resp.status != 200:
-                    text = await resp.text()
-                    raise RuntimeError(f"Ollama error {resp.status}: {text}")
+        async with self._get_session().post(
+            f"{self.base_url}{endpoint}",
+            json=payload
+        ) as resp:
+            if resp.status != 200:
+                text = await resp.text()
+                raise RuntimeError(f"Ollama error {resp.status}: {text}")
+
+            data = await resp.json()
+            elapsed = (time.perf_counter() - t0) * 1000
+            log.debug(f"LLM respondió en {elapsed:.0f}ms")
+            self._record_timing(data, context_key, tier)
 
-                data = await resp.json()
-                elapsed = (time.perf_counter() - t0) * 1000
-                log.debug(f"LLM respondió en {elapsed:.0f}ms")
+            content = strip_markdown(self._content(data))
 
-                content = data["message"]["content"]
+            # Verificar que es JSON válido
+            json.loads(content)  # lanza si no es válido
+            return content
+
+    async def generate_stream(self, game_state_json: str, parser: "IncrementalCommandParser",
+                              session_id: str = None, model: str = None):
+        """
+        Igual que generate() pero consumiendo el stream de tokens de Ollama.
+        Produce cada comando en cuanto su objeto se cierra; al terminar,
+        parser.buffer contiene la respuesta completa.
+        """
+        context_key = self._context_key(session_id, model)
+        endpoint, payload = self._build_payload(game_state_json, True, context_key, model)
+
+        t0 = time.perf_counter()
+        first = True
+        async with self._get_session().post(
+            f"{self.base_url}{endpoint}",
+            json=payload
+        ) as resp:
+            if resp.status != 200:
+                text = await resp.text()
+                raise RuntimeError(f"Ollama error {resp.status}: {text}")
 
-                # Limpiar posibles bloques markdown si el modelo los añade
-                content = content.strip()
-                if content.startswith("```"):
-                    lines = content.split("\n")
-                    content = "\n".join(lines[1:-1])
+            # Ollama envía un objeto JSON por línea
+            async for line in resp.content:
+                line = line.strip()
+                if not line:
+                    continue
+                chunk = json.loads(line)
+                for cmd in parser.feed(self._content(chunk)):
+                    if first:
+                        log.debug(f"Primer comando en {(time.perf_counter() - t0) * 1000:.0f}ms")
+                        first = False
+                    yield cmd
+                if chunk.get("done"):
+                    self._record_timing(chunk, context_key)
+                    break
 
-                # Verificar que es JSON válido
-                json.loads(content)  # lanza si no es válido
-                return content
+        log.debug(f"LLM (stream) respondió en {(time.perf_counter() - t0) * 1000:.0f}ms")
 
     def clear_history(self):
         self._conversation_history = []
+        self._contexts.clear()
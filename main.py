@@ -8,14 +8,22 @@ Arranque: python main.py
 import asyncio
 import json
 import logging
+import math
 import time
 import signal
 import sys
 from aiohttp import web
-from llm_client import OllamaClient
+from llm_client import OllamaClient, IncrementalCommandParser, strip_markdown
 from game_state import GameStateProcessor
 from command_executor import CommandValidator
-from schema import validate_game_state, validate_ai_command
+from command_stream import StreamRegistry, JobQueue, InferenceGate, SUPERSEDED_REASONING
+from tactical_planner import TacticalPlanner
+from response_cache import ResponseCache
+from model_router import ModelRouter
+from sharding import ShardPlanner
+from strategic_planner import TierPlanner
+from replay import ReplayRecorder
+from schema import validate_game_state
 import config as cfg
 
 # ─── Logging ────────────────────────────────────────────────
@@ -36,15 +44,71 @@ class ReforgerAIService:
         )
         self.state_processor = GameStateProcessor()
         self.validator = CommandValidator()
+        self.streams = StreamRegistry(ttl_s=cfg.STREAM_TTL_S)
+        self.jobs = JobQueue(workers=cfg.JOB_WORKERS)
+        self.gate = InferenceGate(max_concurrent=cfg.MAX_CONCURRENT_LLM)
+        self.planner = TacticalPlanner()
+        self.cache = ResponseCache()
+        self.router = ModelRouter()
+        self.sharder = ShardPlanner()
+        self.tiers = TierPlanner()
+        self.recorder = ReplayRecorder(cfg.REPLAY_LOG) if cfg.REPLAY_LOG else None
         self.session_stats = {
             "requests": 0,
             "errors": 0,
             "avg_latency_ms": 0,
+            "keyframes": 0,
+            "delta_ticks": 0,
+            "resyncs": 0,
+            "events_dropped": 0,
+            "events_merged": 0,
+            "streamed_commands": 0,
+            "stream_rejected": 0,
+            "planner_fallbacks": 0,
+            "planner_fast_path": 0,
+            "ticks_skipped": 0,
+            "sharded_ticks": 0,
+            "shard_failures": 0,
+            "shard_conflicts": 0,
+            "llm_commands": 0,
+            "llm_commands_rejected": 0,
+            "llm_batches_rejected": 0,
             "started_at": time.time()
         }
 
     # ─── Handler principal: recibe estado, devuelve comandos ─
     async def handle_command(self, request: web.Request) -> web.Response:
+        if self.recorder is None:
+            return await self._handle_command(request)
+        start = time.perf_counter()
+        arrived = self.recorder.elapsed()
+        response = await self._handle_command(request)
+        raw = await request.text()
+        stream = self._pending_stream(response)
+        if stream is None:
+            self.recorder.record(raw, response.status, response.text,
+                                 (time.perf_counter() - start) * 1000, t=arrived)
+        else:
+            # Solo la primera parte: grabar el resultado completo al terminar
+            asyncio.create_task(self._record_stream(raw, response.status, stream, start, arrived))
+        return response
+
+    def _pending_stream(self, response: web.Response):
+        if response.status not in (200, 202):
+            return None
+        body = json.loads(response.text)
+        return self.streams.get(body["result_id"]) if body.get("more") else None
+
+    async def _record_stream(self, raw: str, status: int, stream, start: float, arrived: float):
+        done = await stream.wait_done(cfg.STREAM_TTL_S)
+        self.recorder.record(raw, status, json.dumps({
+            "command_id": f"cmd_{stream.id}",
+            "reasoning": stream.reasoning,
+            "commands": stream.commands,
+            "superseded": stream.superseded
+        }), (time.perf_counter() - start) * 1000, t=arrived, partial=not done)
+
+    async def _handle_command(self, request: web.Request) -> web.Response:
         start = time.perf_counter()
         self.session_stats["requests"] += 1
 
@@ -57,17 +121,102 @@ class ReforgerAIService:
                 log.warning("GameState inválido recibido")
                 return web.Response(status=400, text='{"error":"invalid_game_state"}')
 
+            # Reconstruir estado completo si el mod envía deltas
+            if game_state.get("delta"):
+                self.session_stats["delta_ticks"] += 1
+            else:
+                self.session_stats["keyframes"] += 1
+            game_state = self.state_processor.reconstruct(game_state)
+            if game_state is None:
+                self.session_stats["resyncs"] += 1
+                return web.Response(status=409, text='{"error":"delta_base_unknown"}')
+
+            # Métricas reportadas por el mod (scheduler, cachés, colas)
+            if "mod_stats" in game_state:
+                self.session_stats["mod_stats"] = game_state["mod_stats"]
+            ev_stats = game_state.get("event_stats", {})
+            self.session_stats["events_dropped"] += ev_stats.get("dropped", 0)
+            self.session_stats["events_merged"] += ev_stats.get("merged", 0)
+
+            # Sin cambios significativos desde la última consulta: no hacer nada
+            must_consult = False
+            if cfg.CHANGE_GATE:
+                score, reasons = self.state_processor.significance(game_state)
+                if score < cfg.CHANGE_THRESHOLD:
+                    self.session_stats["ticks_skipped"] += 1
+                    self._update_latency((time.perf_counter() - start) * 1000)
+                    return web.Response(
+                        content_type="application/json",
+                        text=json.dumps(self.get_skip_command(game_state))
+                    )
+                log.debug(f"Tick {game_state.get('tick', '?')} significativo ({score:.1f}): {', '.join(reasons)}")
+                # Urgente o demasiado tiempo sin consultar: el LLM debe decidir
+                must_consult = score == math.inf
+
+            # Ticks rutinarios: el planificador responde sin consultar al LLM
+            if cfg.PLANNER_FAST_PATH and not must_consult and self.planner.is_routine(game_state):
+                self.session_stats["planner_fast_path"] += 1
+                command = self.planner.plan(game_state, "rutina")
+                # Referencia para la detección de cambios, sin contar como consulta al LLM
+                self.state_processor.remember(game_state, consulted=False)
+                self._update_latency((time.perf_counter() - start) * 1000)
+                return web.Response(
+                    content_type="application/json",
+                    text=json.dumps(command)
+                )
+
+            # Situación ya vista: reutilizar la última respuesta validada
+            # (salvo que el LLM deba decidir)
+            if not must_consult and self.cache.enabled(game_state["session_id"]):
+                cached = self.cache.lookup(game_state)
+                if cached is not None:
+                    # Cuenta como consulta: reinicia el plazo de CHANGE_MAX_IDLE_S
+                    self.state_processor.remember(game_state)
+                    self.planner.observe(game_state["session_id"], cached["commands"])
+                    self._update_latency((time.perf_counter() - start) * 1000)
+                    return web.Response(
+                        content_type="application/json",
+                        text=json.dumps(cached)
+                    )
+
             # Procesar y enriquecer estado
             context = self.state_processor.process(game_state)
 
-            # Llamar al LLM
+            # Modo asíncrono: aceptar ya y resolver en segundo plano
+            if cfg.ASYNC_JOBS:
+                return self._submit_job(game_state, context)
+
+            # Modo streaming: responder con los primeros comandos listos
+            if cfg.LLM_STREAMING:
+                return await self._start_stream(game_state, context, start)
+
+            # Esperar turno: un estado más reciente de la sesión lo sustituye
+            session_id = game_state["session_id"]
+            if not await self.gate.acquire(session_id):
+                log.debug(f"Tick {game_state.get('tick', '?')} sustituido antes de llegar al LLM")
+                return web.Response(
+                    content_type="application/json",
+                    text=json.dumps(self.get_superseded_command(game_state))
+                )
+
+            # Llamar al LLM y validar su respuesta
             log.debug(f"Tick {game_state.get('tick', '?')} — enviando a LLM")
-            ai_response = await self.llm.generate(context)
+            try:
+                command, model = await self._generate(game_state, context)
+                valid = command is not None
+                if not valid:
+                    log.error("LLM devolvió comando inválido, usando fallback")
+            except Exception as e:
+                log.error(f"LLM no disponible ({e}), usando fallback")
+                self.session_stats["errors"] += 1
+                valid = False
+            finally:
+                self.gate.release(session_id)
 
-            # Validar respuesta del LLM
-            command = json.loads(ai_response)
-            if not validate_ai_command(command):
-                log.error("LLM devolvió comando inválido, usando fallback")
+            if valid:
+                self._cache_store(game_state, command)
+                self.planner.observe(session_id, command["commands"])
+            else:
                 command = self.get_fallback_command(game_state)
 
             elapsed = (time.perf_counter() - start) * 1000
@@ -88,9 +237,288 @@ class ReforgerAIService:
             self.session_stats["errors"] += 1
             return web.Response(status=500, text='{"error":"internal_error"}')
 
+    # ─── Streaming: primeros comandos + recogida del resto ───
+    async def _start_stream(self, game_state: dict, context: str, start: float) -> web.Response:
+        stream = self.streams.create(game_state["session_id"], game_state.get("tick"))
+        stream.task = asyncio.create_task(
+            self._run_gated(stream, lambda s: self._run_stream(s, game_state, context))
+        )
+
+        await stream.wait_for_new(cfg.LLM_TIMEOUT)
+
+        elapsed = (time.perf_counter() - start) * 1000
+        self._update_latency(elapsed)
+        log.info(f"Primeros comandos en {elapsed:.0f}ms — stream {stream.id}")
+        return self._stream_response(stream)
+
+    # ─── Trabajos asíncronos: 202 + recogida en /result ──────
+    def _submit_job(self, game_state: dict, context: str) -> web.Response:
+        stream = self.streams.create(game_state["session_id"], game_state.get("tick"))
+        if cfg.LLM_STREAMING:
+            runner = lambda s: self._run_stream(s, game_state, context)
+        else:
+            runner = lambda s: self._run_full(s, game_state, context)
+        self.jobs.submit(stream, lambda s: self._run_gated(s, runner))
+        log.debug(f"Tick {stream.tick} — trabajo {stream.id} en cola ({self.jobs.depth()})")
+        return self._stream_response(stream, status=202)
+
+    async def _run_gated(self, stream, runner):
+        """Ejecuta runner(stream) cuando la sesión y Ollama tienen hueco."""
+        if not await self.gate.acquire(stream.session_id):
+            stream.superseded = True
+            stream.finish(SUPERSEDED_REASONING)
+            return
+        try:
+            await runner(stream)
+        finally:
+            self.gate.release(stream.session_id)
+
+    async def _run_full(self, stream, game_state: dict, context: str):
+        try:
+            log.debug(f"Tick {stream.tick} — enviando a LLM")
+            command, model = await self._generate(game_state, context)
+            if command is not None:
+                self._cache_store(game_state, command)
+                self.planner.observe(stream.session_id, command["commands"])
+            else:
+                log.error("LLM devolvió comando inválido, usando fallback")
+                command = self.get_fallback_command(game_state)
+        except Exception as e:
+            log.error(f"Error en trabajo {stream.id}: {e}")
+            self.session_stats["errors"] += 1
+            command = self.get_fallback_command(game_state)
+
+        for c in command.get("commands", []):
+            stream.push(c)
+        stream.finish(command.get("reasoning", ""))
+
+    async def _generate(self, game_state: dict, context: str):
+        """Llamada completa al modelo elegido por el router. Devuelve
+        (AICommand con solo los comandos válidos, modelo); None si no hay
+        nada aprovechable."""
+        model, why = self.router.choose(game_state, self.state_processor.pressure_level(game_state))
+        if cfg.HIERARCHICAL:
+            return await self._generate_tiered(game_state, context, model), model
+        if cfg.SHARDING:
+            shards = self.sharder.split(game_state)
+            if len(shards) > 1:
+                log.debug(f"Tick {game_state.get('tick', '?')} — {len(shards)} sectores a {model} ({why})")
+                return await self._generate_sharded(shards, model), model
+
+        log.debug(f"Tick {game_state.get('tick', '?')} — enviando a {model} ({why})")
+        command = await self._call_llm(context, game_state["session_id"], model)
+        return (command if self._accept(command, model, game_state) else None), model
+
+    async def _call_llm(self, context: str, session_key: str, model: str, tier: str = "full") -> dict:
+        """Una llamada al modelo con su latencia registrada en el router."""
+        t0 = time.perf_counter()
+        try:
+            command = json.loads(await self.llm.generate(context, session_key, model, tier=tier))
+        except Exception:
+            self.router.record(model, (time.perf_counter() - t0) * 1000, ok=False)
+            raise
+        self.router.record(model, (time.perf_counter() - t0) * 1000, ok=True)
+        return command
+
+    def _accept(self, command: dict, model: str, game_state: dict) -> bool:
+        """Aceptación parcial: descarta solo los comandos inválidos o que no
+        encajan con el estado. False si la estructura no vale o se rechazaron todos."""
+        if not isinstance(command, dict) or not isinstance(command.get("commands"), list):
+            log.warning("AICommand: falta array 'commands'")
+            self.session_stats["llm_batches_rejected"] += 1
+            self.router.record_invalid(model)
+            return False
+        valid, rejected = self.validator.filter(command["commands"], game_state)
+        self.session_stats["llm_commands"] += len(valid) + rejected
+        if rejected:
+            self.session_stats["llm_commands_rejected"] += rejected
+            self.router.record_invalid(model)
+            if not valid:
+                self.session_stats["llm_batches_rejected"] += 1
+                return False
+            log.warning(f"{rejected} comandos inválidos descartados de {model}")
+        command["commands"] = valid
+        return True
+
+    async def _generate_tiered(self, game_state: dict, context: str, model: str) -> dict:
+        """Revisión estratégica (modelo grande salvo degradación) si toca, y después el nivel
+        táctico con los grupos en contacto y sus intenciones."""
+        session_id = game_state["session_id"]
+        reasoning, commands = [], []
+
+        if self.tiers.strategic_due(game_state):
+            big, why = self.router.choose(game_state, self.state_processor.pressure_level(game_state),
+                                          strategic=True)
+            log.debug(f"Tick {game_state.get('tick', '?')} — nivel estratégico a {big} ({why})")
+            strategic = await self._call_llm(context, session_id, big, "strategic")
+            if not self._accept(strategic, big, game_state):
+                raise ValueError("respuesta estratégica inválida")
+            strategic = self.tiers.apply_strategic(game_state, strategic)
+            reasoning.append(f"[estrategia] {strategic.get('reasoning', '')}".rstrip())
+            commands.extend(strategic["commands"])
+
+        tactical_state = self.tiers.tactical_state(game_state)
+        if tactical_state is not None:
+            tactical_context = self.state_processor.process(tactical_state, remember=False)
+            tactical = await self._call_llm(tactical_context, session_id, model, "tactical")
+            if not self._accept(tactical, model, tactical_state):
+                raise ValueError("respuesta táctica inválida")
+            tactical = self.tiers.apply_tactical(tactical_state, tactical)
+            reasoning.append(f"[táctica] {tactical.get('reasoning', '')}".rstrip())
+            commands.extend(tactical["commands"])
+
+        return {
+            "reasoning": " ".join(reasoning) or "Sin contacto: se mantienen las intenciones",
+            "commands": commands
+        }
+
+    async def _generate_sharded(self, shards: list, model: str) -> dict:
+        """Un prompt por sector en paralelo; los sectores que fallan se omiten.
+        El primer worker usa el hueco del turno; cada worker adicional ocupa
+        otro hueco de InferenceGate, así MAX_CONCURRENT_LLM sigue acotando
+        las llamadas simultáneas a Ollama."""
+        self.session_stats["sharded_ticks"] += 1
+        pending = list(enumerate(shards))
+        results = [None] * len(shards)
+        running = set()
+
+        async def run_shard(i, shard):
+            context = self.state_processor.process(shard, remember=False)
+            try:
+                # Sin contexto de Ollama: el índice del sector cambia entre ticks
+                command = await self._call_llm(context, None, model)
+            except Exception as e:
+                log.error(f"Sector {i + 1}: {e}")
+                return None
+            if not self._accept(command, model, shard):
+                return None
+            return shard, command
+
+        async def worker(n):
+            if n:
+                await self.gate.acquire_slot()
+            running.add(n)
+            try:
+                while pending:
+                    i, shard = pending.pop(0)
+                    results[i] = await run_shard(i, shard)
+            finally:
+                if n:
+                    self.gate.release_slot()
+
+        helpers = {n: asyncio.create_task(worker(n))
+                   for n in range(1, min(cfg.SHARD_WORKERS, len(shards)))}
+        try:
+            await worker(0)
+        finally:
+            # Los que aún esperan hueco ya no tienen sectores que resolver
+            for n, task in helpers.items():
+                if n not in running:
+                    task.cancel()
+            await asyncio.gather(*helpers.values(), return_exceptions=True)
+
+        parts = [r for r in results if r is not None]
+        self.session_stats["shard_failures"] += len(shards) - len(parts)
+        if not parts:
+            raise RuntimeError("ningún sector devolvió órdenes válidas")
+
+        command, dropped = self.sharder.merge(parts)
+        self.session_stats["shard_conflicts"] += dropped
+        return command
+
+    async def _run_stream(self, stream, game_state: dict, context: str):
+        parser = IncrementalCommandParser()
+        reasoning = ""
+        model, why = self.router.choose(game_state, self.state_processor.pressure_level(game_state))
+        entities = self.validator.entities(game_state)
+        received = 0
+        t0 = time.perf_counter()
+        try:
+            log.debug(f"Tick {stream.tick} — enviando a {model} (stream, {why})")
+            async for cmd in self.llm.generate_stream(context, parser, stream.session_id, model):
+                self.session_stats["llm_commands"] += 1
+                received += 1
+                if self.validator.accept(cmd, entities, received - 1):
+                    stream.push(cmd)
+                    self.planner.observe(stream.session_id, [cmd])
+                    self.session_stats["streamed_commands"] += 1
+                else:
+                    self.session_stats["stream_rejected"] += 1
+                    self.session_stats["llm_commands_rejected"] += 1
+                    self.router.record_invalid(model)
+            self.router.record(model, (time.perf_counter() - t0) * 1000, ok=True)
+            try:
+                reasoning = json.loads(strip_markdown(parser.buffer)).get("reasoning", "")
+                self._cache_store(game_state, {"reasoning": reasoning, "commands": list(stream.commands)})
+            except ValueError:
+                log.warning("Respuesta completa del stream no es JSON válido")
+        except asyncio.CancelledError:
+            raise
+        except Exception as e:
+            log.error(f"Error en stream {stream.id}: {e}")
+            self.session_stats["errors"] += 1
+            self.router.record(model, (time.perf_counter() - t0) * 1000, ok=False)
+            # Sin nada entregado todavía: que el planificador cubra el tick
+            if not stream.commands:
+                command = self.get_fallback_command(game_state)
+                for c in command["commands"]:
+                    stream.push(c)
+                reasoning = command["reasoning"]
+        finally:
+            stream.finish(reasoning)
+
+    def _cache_store(self, game_state: dict, command: dict):
+        if self.cache.enabled(game_state["session_id"]):
+            self.cache.store(game_state, command)
+
+    # ─── Caché de respuestas por sesión ─────────────────────
+    async def handle_cache(self, request: web.Request) -> web.Response:
+        """POST /cache/<session_id> {"enabled": false} desactiva la caché de esa sesión."""
+        session_id = request.match_info["session_id"]
+        try:
+            enabled = bool(json.loads(await request.text()).get("enabled", True))
+        except (ValueError, AttributeError):
+            return web.Response(status=400, text='{"error":"json_parse_error"}')
+
+        self.cache.set_enabled(session_id, enabled)
+        log.info(f"Caché de respuestas {'activada' if enabled else 'desactivada'} para {session_id}")
+        return web.Response(
+            content_type="application/json",
+            text=json.dumps({"session_id": session_id, "enabled": enabled})
+        )
+
+    async def handle_result(self, request: web.Request) -> web.Response:
+        stream = self.streams.get(request.match_info["result_id"])
+        if stream is None:
+            return web.Response(status=404, text='{"error":"unknown_result"}')
+
+        await stream.wait_for_new(cfg.STREAM_POLL_TIMEOUT)
+        return self._stream_response(stream)
+
+    def _stream_response(self, stream, status: int = 200) -> web.Response:
+        commands = stream.take_new()
+        more = not stream.drained
+        if not more:
+            self.streams.drop(stream.id)
+
+        return web.Response(
+            status=status,
+            content_type="application/json",
+            text=json.dumps({
+                "command_id": f"cmd_{stream.id}_{stream.delivered}",
+                "timestamp": time.time(),
+                "reasoning": stream.reasoning,
+                "commands": commands,
+                "result_id": stream.id,
+                "more": more,
+                "superseded": stream.superseded
+            })
+        )
+
     # ─── Health check ────────────────────────────────────────
     async def handle_health(self, request: web.Request) -> web.Response:
-        llm_ok = await self.llm.ping()
+        # Estado cacheado: /health nunca espera a Ollama
+        llm_ok = self.llm.reachable
         uptime = int(time.time() - self.session_stats["started_at"])
         return web.Response(
             content_type="application/json",
@@ -98,6 +526,7 @@ class ReforgerAIService:
                 "status": "ok" if llm_ok else "degraded",
                 "llm": cfg.OLLAMA_MODEL,
                 "llm_reachable": llm_ok,
+                "llm_checked_s_ago": int(time.time() - self.llm.last_health_check),
                 "uptime_s": uptime,
                 "stats": self.session_stats
             })
@@ -105,20 +534,51 @@ class ReforgerAIService:
 
     # ─── Stats endpoint ──────────────────────────────────────
     async def handle_stats(self, request: web.Request) -> web.Response:
+        stats = dict(self.session_stats)
+        stats["job_queue_depth"] = self.jobs.depth()
+        stats["jobs_superseded"] = self.jobs.superseded
+        stats["pending_results"] = len(self.streams)
+        stats["llm_queue"] = self.gate.stats()
+        stats["llm_timing"] = self.llm.timing_stats()
+        stats["compression"] = self.state_processor.compressor.stats()
+        stats["planner_avg_ms"] = round(self.planner.avg_ms, 2)
+        stats["response_cache"] = self.cache.stats()
+        stats["models"] = self.router.stats()
+        stats["tiers"] = self.tiers.stats()
+        stats["validator"] = self.validator.stats()
+        stats["replay_records"] = self.recorder.records if self.recorder else None
+        stats["structured_output"] = cfg.STRUCTURED_OUTPUT
+        stats["rejection_rate"] = round(stats["llm_commands_rejected"] / max(1, stats["llm_commands"]), 3)
+        stats["skip_ratio"] = round(stats["ticks_skipped"] / max(1, stats["requests"]), 3)
         return web.Response(
             content_type="application/json",
-            text=json.dumps(self.session_stats)
+            text=json.dumps(stats)
         )
 
     # ─── Fallback cuando el LLM falla ───────────────────────
     def get_fallback_command(self, game_state: dict) -> dict:
+        self.session_stats["planner_fallbacks"] += 1
+        return self.planner.plan(game_state, "fallback")
+
+    # ─── Respuesta para ticks sin cambios ───────────────────
+    def get_skip_command(self, game_state: dict) -> dict:
         return {
-            "command_id": f"fallback_{int(time.time())}",
+            "command_id": f"skip_{game_state.get('tick', 0)}",
             "timestamp": time.time(),
-            "reasoning": "Fallback: LLM no disponible, manteniendo estado actual",
+            "reasoning": "Sin cambios significativos",
             "commands": []
         }
 
+    # ─── Respuesta para estados sustituidos en cola ─────────
+    def get_superseded_command(self, game_state: dict) -> dict:
+        return {
+            "command_id": f"superseded_{game_state.get('tick', 0)}",
+            "timestamp": time.time(),
+            "reasoning": SUPERSEDED_REASONING,
+            "commands": [],
+            "superseded": True
+        }
+
     def _update_latency(self, ms: float):
         n = self.session_stats["requests"]
         prev = self.session_stats["avg_latency_ms"]
@@ -131,15 +591,27 @@ async def main():
 
     app = web.Application()
     app.router.add_post("/command", service.handle_command)
+    app.router.add_get("/result/{result_id}", service.handle_result)
+    app.router.add_post("/cache/{session_id}", service.handle_cache)
     app.router.add_get("/health",   service.handle_health)
     app.router.add_get("/stats",    service.handle_stats)
 
     # Comprobación inicial del LLM
     log.info(f"Verificando conexión con Ollama en {cfg.OLLAMA_URL} ...")
-    if not await service.llm.ping():
+    await service.llm.start()
+    if not service.llm.reachable:
         log.warning("⚠️  Ollama no responde — el servicio arrancará en modo degradado")
     else:
         log.info(f"✓ Ollama conectado. Modelo: {cfg.OLLAMA_MODEL}")
+        if service.router.routing:
+            log.info(f"  Modelo rápido para ticks rutinarios: {cfg.OLLAMA_FAST_MODEL}")
+            await service.llm.preload(cfg.OLLAMA_FAST_MODEL)
+
+    if cfg.LLM_STREAMING and (cfg.HIERARCHICAL or cfg.SHARDING):
+        log.warning("RAI_STREAMING activo: RAI_HIERARCHICAL y RAI_SHARDING no se aplican")
+
+    if cfg.ASYNC_JOBS:
+        service.jobs.start()
 
     runner = web.AppRunner(app)
     await runner.setup()
@@ -148,6 +620,8 @@ async def main():
 
     log.info(f"🚀 ReforgerAI Service escuchando en http://{cfg.BIND_HOST}:{cfg.BIND_PORT}")
     log.info("   POST /command  — recibe GameState, devuelve AICommand")
+    log.info("   GET  /result/<id> — resto de comandos de una respuesta parcial")
+    log.info("   POST /cache/<session> — activar/desactivar caché de respuestas")
     log.info("   GET  /health   — estado del servicio")
     log.info("   GET  /stats    — estadísticas de sesión")
     log.info("Pulsa Ctrl+C para detener")
@@ -164,6 +638,10 @@ async def main():
 
     await stop_event.wait()
     await runner.cleanup()
+    await service.jobs.close()
+    await service.llm.close()
+    if service.recorder:
+        service.recorder.close()
     log.info("Servicio detenido.")
 
 
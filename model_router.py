@@ -0,0 +1,126 @@
+"""
+model_router.py — Elección de modelo por petición
+Los ticks rutinarios van a un modelo pequeño y rápido; las crisis, las
+decisiones estratégicas periódicas y los momentos sin misiones al modelo
+grande. Si el grande incumple el SLO de latencia se degrada temporalmente
+al rápido.
+"""
+
+import logging
+import time
+import config as cfg
+
+log = logging.getLogger("ReforgerAI.Router")
+
+# Eventos que justifican el modelo grande
+CRISIS_EVENTS = {
+    "PLAYER_DOWNED", "OBJECTIVE_CAPTURED", "MISSION_FAILED",
+    "MISSION_COMPLETED", "VEHICLE_DESTROYED"
+}
+CRISIS_PRESSURE = {"CRITICAL", "HIGH"}
+
+# Peso de la última muestra en la media de latencia
+LATENCY_SMOOTHING = 0.3
+# Muestras mínimas antes de juzgar el SLO
+SLO_MIN_SAMPLES = 3
+
+
+class ModelStats:
+    def __init__(self):
+        self.calls = 0
+        self.errors = 0
+        self.invalid = 0
+        self.avg_latency_ms = 0.0
+        self.samples = 0
+
+    def record_latency(self, ms: float):
+        self.samples += 1
+        if self.samples == 1:
+            self.avg_latency_ms = ms
+        else:
+            self.avg_latency_ms += (ms - self.avg_latency_ms) * LATENCY_SMOOTHING
+
+    def to_dict(self) -> dict:
+        return {
+            "calls": self.calls,
+            "errors": self.errors,
+            "invalid": self.invalid,
+            "avg_latency_ms": round(self.avg_latency_ms, 1)
+        }
+
+
+class ModelRouter:
+    def __init__(self, big_model: str = cfg.OLLAMA_MODEL, fast_model: str = cfg.OLLAMA_FAST_MODEL):
+        self.big = big_model
+        self.fast = fast_model or big_model
+        self._stats = {}
+        self._last_big_at = 0.0
+        self._demoted_until = 0.0
+        self.demotions = 0
+
+    @property
+    def routing(self) -> bool:
+        return self.fast != self.big
+
+    # ─── Elección ───────────────────────────────────────────
+    def choose(self, gs: dict, pressure: str, strategic: bool = False):
+        """Devuelve (modelo, motivo). strategic: pasada del nivel estratégico,
+        que usa el grande salvo que esté degradado."""
+        if not self.routing:
+            return self.big, "único"
+
+        now = time.monotonic()
+        if now < self._demoted_until:
+            return self.fast, "grande degradado por SLO"
+        if strategic:
+            return self.big, "nivel estratégico"
+        if gs.get("urgent") or any(e.get("type") in CRISIS_EVENTS for e in gs.get("events", [])):
+            return self.big, "evento crítico"
+        if pressure in CRISIS_PRESSURE:
+            return self.big, f"presión {pressure}"
+        if not gs.get("active_missions"):
+            return self.big, "sin misiones activas"
+        if now - self._last_big_at >= cfg.BIG_MODEL_INTERVAL_S:
+            return self.big, "revisión estratégica"
+        return self.fast, "rutina"
+
+    # ─── Resultados ─────────────────────────────────────────
+    def record(self, model: str, latency_ms: float, ok: bool):
+        st = self._stat(model)
+        st.calls += 1
+        if not ok:
+            st.errors += 1
+            return
+        st.record_latency(latency_ms)
+
+        if model != self.big or not self.routing:
+            return
+        self._last_big_at = time.monotonic()
+        if st.samples >= SLO_MIN_SAMPLES and st.avg_latency_ms > cfg.BIG_MODEL_SLO_MS:
+            self._demote(st)
+
+    def record_invalid(self, model: str):
+        self._stat(model).invalid += 1
+
+    def _demote(self, st: ModelStats):
+        self._demoted_until = time.monotonic() + cfg.DEMOTION_COOLDOWN_S
+        self.demotions += 1
+        log.warning(f"{self.big} supera el SLO ({st.avg_latency_ms:.0f}ms > {cfg.BIG_MODEL_SLO_MS:.0f}ms), "
+                    f"usando {self.fast} durante {cfg.DEMOTION_COOLDOWN_S:.0f}s")
+        # Al volver se mide de nuevo desde cero
+        st.samples = 0
+
+    def _stat(self, model: str) -> ModelStats:
+        st = self._stats.get(model)
+        if st is None:
+            st = self._stats[model] = ModelStats()
+        return st
+
+    def stats(self) -> dict:
+        return {
+            "big": self.big,
+            "fast": self.fast,
+            "demoted": time.monotonic() < self._demoted_until,
+            "demotions": self.demotions,
+            "models": {m: st.to_dict() for m, st in self._stats.items()}
+        }
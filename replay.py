@@ -0,0 +1,74 @@
+"""
+replay.py — Registro de sesiones para reproducirlas después
+Guarda en un JSONL de solo anexado cada GameState recibido (tal cual llega,
+con deltas incluidos) junto con la respuesta enviada y su latencia. bench.py
+lo reproduce contra el servicio con un Ollama simulado.
+"""
+
+import json
+import logging
+import time
+
+log = logging.getLogger("ReforgerAI.Replay")
+
+
+class ReplayRecorder:
+    """Una línea por petición:
+    {"t": s desde el inicio, "ms": latencia, "status": http, "state": GameState, "response": AICommand}
+    Con respuestas en varias partes (streaming, trabajos) "response" es el
+    resultado completo; si no llegó a completarse se marca "partial": true."""
+
+    def __init__(self, path: str):
+        self.path = path
+        self.records = 0
+        self._started = time.monotonic()
+        # Con buffer de línea: cada registro llega al disco aunque el servicio caiga
+        self._file = open(path, "a", encoding="utf-8", buffering=1)
+        log.info(f"Grabando sesiones en {path}")
+
+    def elapsed(self) -> float:
+        return time.monotonic() - self._started
+
+    def record(self, raw_state: str, status: int, response_text: str, latency_ms: float,
+               t: float = None, partial: bool = False):
+        """t: llegada del estado (por defecto, ahora)."""
+        # Lo que no se pudo parsear tampoco se puede reproducir; y un resultado
+        # que termina tras el cierre ya no tiene dónde escribirse
+        if status == 400 or self._file.closed:
+            return
+        if t is None:
+            t = self.elapsed()
+        # Estado y respuesta ya son JSON: se insertan sin volver a serializar,
+        # salvo que traigan saltos de línea que romperían el JSONL
+        state = raw_state.strip()
+        if "\n" in state:
+            state = json.dumps(json.loads(state), separators=(",", ":"))
+        self._file.write(
+            f'{{"t":{t:.3f},"ms":{latency_ms:.1f},"status":{status},'
+            + ('"partial":true,' if partial else '')
+            + f'"state":{state},"response":{response_text or "null"}}}\n'
+        )
+        self.records += 1
+
+    def close(self):
+        if not self._file.closed:
+            self._file.close()
+            log.info(f"Grabación cerrada: {self.records} peticiones en {self.path}")
+
+
+def load_replay(path: str) -> list:
+    """Registros de un fichero de replay, en orden de llegada; las líneas
+    dañadas se omiten."""
+    records = []
+    with open(path, encoding="utf-8") as f:
+        for n, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                records.append(json.loads(line))
+            except ValueError:
+                log.warning(f"{path}:{n}: línea dañada, omitida")
+    # Las respuestas en varias partes se escriben al completarse
+    records.sort(key=lambda r: r.get("t", 0.0))
+    return records
@@ -0,0 +1,154 @@
+"""
+response_cache.py — Caché LRU de órdenes por situación táctica
+La clave es una huella cuantizada del estado (posiciones por sector,
+salud por tramos, tipos de evento), de modo que situaciones casi iguales
+reutilizan la última respuesta validada del LLM.
+"""
+
+import copy
+import json
+import logging
+import time
+from collections import OrderedDict
+import config as cfg
+
+log = logging.getLogger("ReforgerAI.Cache")
+
+# Prefijo de "reasoning" de las respuestas servidas desde la caché
+CACHE_TAG = "[cache]"
+
+# Solo se reutilizan órdenes a grupos existentes: repetir SPAWN_GROUP,
+# CALL_REINFORCEMENTS o CREATE_MISSION volvería a crear lo mismo
+REPLAYABLE_COMMANDS = {"SET_FORMATION", "SET_WAYPOINT", "SET_BEHAVIOR", "SET_AMBUSH"}
+
+
+class CacheEntry:
+    def __init__(self, session_id: str, features: frozenset, command: dict):
+        self.session_id = session_id
+        self.features = features
+        self.command = command
+        self.stored_at = time.monotonic()
+
+
+class ResponseCache:
+    def __init__(self, capacity: int = cfg.CACHE_SIZE, ttl_s: float = cfg.CACHE_TTL_S,
+                 similarity: float = cfg.CACHE_SIMILARITY):
+        self.capacity = capacity
+        self.ttl_s = ttl_s
+        self.similarity = similarity
+        self._entries = OrderedDict()  # clave -> CacheEntry
+        self._disabled = set()         # sesiones sin caché
+        self.hits = 0
+        self.near_hits = 0
+        self.misses = 0
+
+    # ─── Huella del estado ──────────────────────────────────
+    @staticmethod
+    def features(gs: dict) -> frozenset:
+        """Rasgos cuantizados de la situación; iguales rasgos, misma respuesta."""
+        size = cfg.CACHE_CELL_SIZE
+
+        def cell(pos):
+            if not isinstance(pos, dict):
+                return "?"
+            return f"{int(pos.get('x', 0) // size)}_{int(pos.get('z', 0) // size)}"
+
+        out = set()
+        for p in gs.get("players", []):
+            out.add(("p", p.get("faction"), cell(p.get("position")), p.get("alive", True)))
+        for g in gs.get("ai_groups", []):
+            health = int(g.get("health_avg", 100) // cfg.CACHE_HEALTH_BUCKET)
+            out.add(("g", g.get("group_id"), cell(g.get("position")), health, g.get("state")))
+        for e in gs.get("events", []):
+            out.add(("e", e.get("type"), e.get("source_group")))
+        for m in gs.get("active_missions", []):
+            out.add(("m", m.get("mission_id"), m.get("status")))
+        return frozenset(out)
+
+    @staticmethod
+    def _key(session_id: str, features: frozenset) -> str:
+        return session_id + ":" + json.dumps(sorted(features, key=repr), default=str)
+
+    # ─── Consulta / almacenamiento ──────────────────────────
+    def enabled(self, session_id: str) -> bool:
+        return cfg.RESPONSE_CACHE and session_id not in self._disabled
+
+    def set_enabled(self, session_id: str, enabled: bool):
+        if enabled:
+            self._disabled.discard(session_id)
+        else:
+            self._disabled.add(session_id)
+            self.drop_session(session_id)
+
+    def lookup(self, gs: dict):
+        """Devuelve una copia del AICommand cacheado o None."""
+        session_id = gs["session_id"]
+        feats = self.features(gs)
+        now = time.monotonic()
+
+        entry = self._entries.get(self._key(session_id, feats))
+        near = False
+        if entry is None and self.similarity < 1.0:
+            entry = self._nearest(session_id, feats, now)
+            near = entry is not None
+
+        if entry is None or now - entry.stored_at > self.ttl_s:
+            self.misses += 1
+            return None
+
+        self._entries.move_to_end(self._key(session_id, entry.features))
+        if near:
+            self.near_hits += 1
+        else:
+            self.hits += 1
+
+        command = copy.deepcopy(entry.command)
+        command["command_id"] = f"cache_{gs.get('tick', 0)}"
+        command["timestamp"] = time.time()
+        command["reasoning"] = f"{CACHE_TAG} {command.get('reasoning', '')}".rstrip()
+        return command
+
+    def store(self, gs: dict, command: dict):
+        session_id = gs["session_id"]
+        feats = self.features(gs)
+        key = self._key(session_id, feats)
+        self._entries.pop(key, None)
+
+        orders = [c for c in command.get("commands", []) if c.get("type") in REPLAYABLE_COMMANDS]
+        if not orders:
+            return
+        command = copy.deepcopy(dict(command, commands=orders))
+        self._entries[key] = CacheEntry(session_id, feats, command)
+        while len(self._entries) > self.capacity:
+            self._entries.popitem(last=False)
+
+    def drop_session(self, session_id: str):
+        for key in [k for k, e in self._entries.items() if e.session_id == session_id]:
+            del self._entries[key]
+
+    def _nearest(self, session_id: str, feats: frozenset, now: float):
+        """Entrada vigente más parecida (Jaccard) por encima del umbral. Solo
+        se aceptan entradas con los mismos grupos: las órdenes los nombran."""
+        groups = {f[1] for f in feats if f[0] == "g"}
+        best, best_sim = None, self.similarity
+        for entry in self._entries.values():
+            if entry.session_id != session_id or now - entry.stored_at > self.ttl_s:
+                continue
+            if {f[1] for f in entry.features if f[0] == "g"} != groups:
+                continue
+            union = len(feats | entry.features)
+            sim = len(feats & entry.features) / union if union else 1.0
+            if sim >= best_sim:
+                best, best_sim = entry, sim
+        return best
+
+    def stats(self) -> dict:
+        total = self.hits + self.near_hits + self.misses
+        return {
+            "size": len(self._entries),
+            "hits": self.hits,
+            "near_hits": self.near_hits,
+            "misses": self.misses,
+            "hit_rate": round((self.hits + self.near_hits) / total, 3) if total else 0.0,
+            "disabled_sessions": sorted(self._disabled)
+        }
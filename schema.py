@@ -2,7 +2,6 @@
 schema.py — Validación de GameState y AICommand
 """
 
-import json
 import logging
 
 log = logging.getLogger("ReforgerAI.Schema")
@@ -22,6 +21,64 @@ VALID_FORMATIONS = {
 VALID_BEHAVIORS = {"SAFE", "AWARE", "COMBAT", "STEALTH"}
 VALID_WP_BEHAVIORS = {"PATROL", "ASSAULT", "DEFEND", "RETREAT", "FLANK"}
 
+POSITION_SCHEMA = {
+    "type": "object",
+    "properties": {"x": {"type": "number"}, "y": {"type": "number"}, "z": {"type": "number"}},
+    "required": ["x", "y", "z"]
+}
+_STRING = {"type": "string"}
+
+
+def _enum(values: set) -> dict:
+    return {"type": "string", "enum": sorted(values)}
+
+
+# Parámetros que lee AICommandReceiver por tipo: (propiedades, obligatorios)
+COMMAND_PARAMS = {
+    "SET_FORMATION": ({"formation": _enum(VALID_FORMATIONS)}, ["formation"]),
+    "SET_WAYPOINT": ({"position": POSITION_SCHEMA, "behavior": _enum(VALID_WP_BEHAVIORS)}, ["position", "behavior"]),
+    "SET_BEHAVIOR": ({"behavior": _enum(VALID_BEHAVIORS)}, ["behavior"]),
+    "SPAWN_GROUP": ({"faction": _STRING, "template": _STRING, "position": POSITION_SCHEMA,
+                     "assign_mission": _STRING}, ["faction", "template", "position"]),
+    "DESPAWN_GROUP": ({}, []),
+    "UPDATE_MISSION": ({"new_objective": POSITION_SCHEMA, "priority": _STRING}, []),
+    "CREATE_MISSION": ({"type": _STRING, "objective_position": POSITION_SCHEMA,
+                        "time_limit": {"type": "number"}}, ["type", "objective_position"]),
+    "END_MISSION": ({}, []),
+    "CALL_REINFORCEMENTS": ({"faction": _STRING, "position": POSITION_SCHEMA,
+                             "group_count": {"type": "integer"}}, ["faction", "position"]),
+    "SET_AMBUSH": ({"position": POSITION_SCHEMA}, ["position"]),
+    "BROADCAST_MESSAGE": ({"message": _STRING, "duration": {"type": "integer"}}, ["message"]),
+    "TRIGGER_EVENT": ({"event_name": _STRING}, ["event_name"]),
+    "VEHICLE_ORDER": ({"order": _STRING}, ["order"]),
+}
+
+
+def ai_command_schema(command_types=VALID_COMMAND_TYPES, extra: dict = None) -> dict:
+    """
+    JSON Schema del AICommand para la salida estructurada de Ollama
+    ("format"): una variante por tipo de comando, con sus parámetros y enums.
+    extra añade propiedades de primer nivel (p. ej. "intents").
+    """
+    variants = []
+    for ctype in sorted(command_types):
+        props, required = COMMAND_PARAMS[ctype]
+        variants.append({
+            "type": "object",
+            "properties": {
+                "type": {"type": "string", "enum": [ctype]},
+                "target": _STRING,
+                "params": {"type": "object", "properties": props, "required": required}
+            },
+            "required": ["type", "target", "params"]
+        })
+    properties = {
+        "reasoning": _STRING,
+        "commands": {"type": "array", "items": {"anyOf": variants}}
+    }
+    properties.update(extra or {})
+    return {"type": "object", "properties": properties, "required": ["reasoning", "commands"]}
+
 
 def validate_game_state(gs: dict) -> bool:
     """Valida que el GameState tenga los campos mínimos requeridos."""
@@ -32,23 +89,3 @@ def validate_game_state(gs: dict) -> bool:
             return False
     return True
 
-
-def validate_ai_command(cmd: dict) -> bool:
-    """Valida que el AICommand tenga estructura correcta."""
-    if "commands" not in cmd:
-        log.warning("AICommand: falta array 'commands'")
-        return False
-
-    if not isinstance(cmd["commands"], list):
-        log.warning("AICommand: 'commands' no es array")
-        return False
-
-    for i, c in enumerate(cmd["commands"]):
-        if "type" not in c:
-            log.warning(f"Comando {i}: falta 'type'")
-            return False
-        if c["type"] not in VALID_COMMAND_TYPES:
-            log.warning(f"Comando {i}: tipo inválido '{c['type']}'")
-            return False
-
-    return True
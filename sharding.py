@@ -0,0 +1,158 @@
+"""
+sharding.py — Inferencia por sectores operacionales
+Divide los grupos IA en sectores independientes alrededor de las
+concentraciones de jugadores, para lanzar un prompt pequeño por sector en
+paralelo, y fusiona después las órdenes resolviendo conflictos.
+"""
+
+import logging
+import math
+import config as cfg
+from command_executor import GROUP_TARGETS
+from game_state import SpatialGrid
+
+log = logging.getLogger("ReforgerAI.Shard")
+
+# Órdenes sobre el mundo (no sobre un grupo) y cuántas se admiten por tick
+GLOBAL_LIMITS = {
+    "BROADCAST_MESSAGE": 1,
+    "CREATE_MISSION": 1,
+    "TRIGGER_EVENT": 1,
+    "SPAWN_GROUP": cfg.SHARD_MAX_SPAWNS,
+    "CALL_REINFORCEMENTS": cfg.SHARD_MAX_SPAWNS,
+}
+# Se cuentan juntas contra el mismo límite
+SPAWN_TYPES = {"SPAWN_GROUP", "CALL_REINFORCEMENTS"}
+MISSION_TYPES = {"UPDATE_MISSION", "END_MISSION"}
+
+
+class Shard:
+    def __init__(self, index: int, center: dict):
+        self.index = index
+        self.center = center
+        self.player_ids = set()
+        self.group_ids = set()
+
+    def describe(self, total: int) -> dict:
+        return {
+            "sector": self.index + 1,
+            "of": total,
+            "center": self.center,
+            "note": "Ordena solo a los grupos de este sector; otros sectores se resuelven aparte"
+        }
+
+
+class ShardPlanner:
+    # ─── División ───────────────────────────────────────────
+    def split(self, gs: dict) -> list:
+        """
+        Devuelve la lista de GameStates de cada sector (con "_shard"), o una
+        lista de un elemento si no merece la pena dividir.
+        """
+        groups = [g for g in gs.get("ai_groups", []) if isinstance(g.get("position"), dict)]
+        if len(groups) < cfg.SHARD_MIN_GROUPS:
+            return [gs]
+
+        grid = SpatialGrid.from_state(gs)
+        clusters = grid.player_clusters(cfg.SHARD_CLUSTER_RADIUS)[:cfg.SHARD_MAX]
+        if len(clusters) < 2:
+            return [gs]
+
+        shards = [Shard(i, c["center"]) for i, c in enumerate(clusters)]
+        clustered = set()
+        for shard, c in zip(shards, clusters):
+            shard.player_ids.update(c["players"])
+            clustered.update(c["players"])
+
+        # Grupos y jugadores sueltos (caídos, fuera de los clusters más
+        # grandes) van al sector más cercano
+        for g in groups:
+            self._nearest_shard(shards, g["position"]).group_ids.add(g.get("group_id"))
+        for p in gs.get("players", []):
+            if p.get("id") not in clustered and isinstance(p.get("position"), dict):
+                self._nearest_shard(shards, p["position"]).player_ids.add(p.get("id"))
+        shards = [s for s in shards if s.group_ids]
+        if len(shards) < 2:
+            return [gs]
+
+        return [self._shard_state(gs, s, len(shards), first=(i == 0)) for i, s in enumerate(shards)]
+
+    @staticmethod
+    def _nearest_shard(shards: list, pos: dict) -> Shard:
+        return min(shards, key=lambda s: math.hypot(pos["x"] - s.center["x"], pos["z"] - s.center["z"]))
+
+    def _shard_state(self, gs: dict, shard: Shard, total: int, first: bool) -> dict:
+        state = {k: v for k, v in gs.items()
+                 if k not in ("players", "ai_groups", "events", "active_missions")}
+        state["players"] = [p for p in gs.get("players", []) if p.get("id") in shard.player_ids]
+        state["ai_groups"] = [g for g in gs.get("ai_groups", []) if g.get("group_id") in shard.group_ids]
+        state["events"] = [e for e in gs.get("events", []) if self._event_in(e, shard, first)]
+        # Misiones de los grupos del sector; las que no tienen grupos, al primero
+        state["active_missions"] = [
+            m for m in gs.get("active_missions", [])
+            if shard.group_ids & set(m.get("assigned_groups", [])) or (first and not m.get("assigned_groups"))
+        ]
+        state["_shard"] = shard.describe(total)
+        return state
+
+    @staticmethod
+    def _event_in(e: dict, shard: Shard, first: bool) -> bool:
+        src = e.get("source_group")
+        if src:
+            return src in shard.group_ids
+        player = e.get("data", {}).get("player_id")
+        if player:
+            return player in shard.player_ids
+        return first
+
+    # ─── Fusión ─────────────────────────────────────────────
+    def merge(self, parts: list):
+        """
+        parts: [(estado_del_sector, AICommand)]. Cada sector solo puede
+        ordenar a sus grupos; las órdenes globales se limitan y deduplican.
+        Devuelve (AICommand, órdenes descartadas).
+        """
+        commands, reasoning = [], []
+        seen_targets = set()
+        global_counts = {}
+        dropped = 0
+
+        for shard_state, command in parts:
+            own_groups = {g.get("group_id") for g in shard_state.get("ai_groups", [])}
+            own_missions = {m.get("mission_id") for m in shard_state.get("active_missions", [])}
+            sector = shard_state.get("_shard", {}).get("sector", 1)
+            if command.get("reasoning"):
+                reasoning.append(f"[sector {sector}] {command['reasoning']}")
+
+            for c in command.get("commands", []):
+                ctype, target = c.get("type"), c.get("target")
+                limit_key = "SPAWN_GROUP" if ctype in SPAWN_TYPES else ctype
+
+                if limit_key in GLOBAL_LIMITS:
+                    if global_counts.get(limit_key, 0) >= GLOBAL_LIMITS[limit_key]:
+                        dropped += 1
+                        continue
+                    global_counts[limit_key] = global_counts.get(limit_key, 0) + 1
+                elif ctype in MISSION_TYPES:
+                    if target not in own_missions or (ctype, target) in seen_targets:
+                        dropped += 1
+                        continue
+                    seen_targets.add((ctype, target))
+                elif ctype in GROUP_TARGETS:
+                    # Órdenes de grupo: solo el sector dueño, una por tipo
+                    if target not in own_groups or (ctype, target) in seen_targets:
+                        dropped += 1
+                        continue
+                    seen_targets.add((ctype, target))
+                else:
+                    # Objetivos fuera de los sectores (vehículos): el primero que
+                    # lo ordena se queda con él
+                    if (ctype, target) in seen_targets:
+                        dropped += 1
+                        continue
+                    seen_targets.add((ctype, target))
+                commands.append(c)
+
+        if dropped:
+            log.debug(f"Fusión de sectores: {dropped} órdenes descartadas por conflicto")
+        return {"reasoning": " ".join(reasoning), "commands": commands}, dropped
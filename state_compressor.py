@@ -0,0 +1,294 @@
+"""
+state_compressor.py — Ajusta el GameState enriquecido a un presupuesto de tokens
+Aplica reducciones cada vez más agresivas solo mientras el estado no quepa
+en la ventana de contexto reservada para él.
+"""
+
+import copy
+import json
+import logging
+import math
+import config as cfg
+
+log = logging.getLogger("ReforgerAI.Compressor")
+
+# Aproximación conservadora para JSON con texto en español
+CHARS_PER_TOKEN = 3.2
+
+# Valores por defecto que se omiten, por sección (se declaran en "_defaults").
+# Son los campos que escriben AIBridge (jugadores), AIGroupController y
+# AIMissionManager (solo serializa misiones activas)
+SECTION_DEFAULTS = {
+    "players": {"health": 100, "alive": True, "in_vehicle": False},
+    "ai_groups": {"health_avg": 100},
+    "active_missions": {"status": "ACTIVE", "completion": 0},
+}
+
+# Nombres de campo largos → compactos (la leyenda viaja en "_keys"): campos
+# de entidades y eventos que escribe el mod. Las claves que el propio
+# compresor consulta después ("events", "_meta", "sectors"...) no se renombran
+KEY_MAP = {
+    "position": "pos",
+    "group_id": "gid",
+    "unit_count": "n",
+    "health_avg": "hp_avg",
+    "health": "hp",
+    "in_vehicle": "veh",
+    "mission_id": "mid",
+    "objective_position": "obj",
+    "completion": "cmpl",
+    "event_id": "eid",
+    "source_group": "src",
+    "timestamp": "ts",
+    "last_timestamp": "last_ts",
+    "enemy_position": "e_pos",
+    "enemy_count": "e_n",
+    "distance": "dist",
+}
+
+# Campos del nivel superior que nunca se renombran ni recortan
+PROTECTED_KEYS = {"session_id", "tick", "map", "game_mode"}
+
+
+def estimate_tokens(text: str) -> int:
+    return int(len(text) / CHARS_PER_TOKEN) + 1
+
+
+def _dump(state: dict) -> str:
+    return json.dumps(state, ensure_ascii=False, separators=(",", ":"))
+
+
+def _is_position(value) -> bool:
+    return isinstance(value, dict) and "x" in value and "z" in value
+
+
+def _round_positions(node, step: float):
+    """Redondea recursivamente todas las posiciones {x,y,z} a múltiplos de step."""
+    if isinstance(node, dict):
+        for key, value in node.items():
+            if _is_position(value):
+                for axis in ("x", "y", "z"):
+                    if axis in value:
+                        v = round(value[axis] / step) * step
+                        value[axis] = int(v) if step >= 1 else round(v, 1)
+            elif isinstance(value, float):
+                node[key] = round(value, 2)
+            else:
+                _round_positions(value, step)
+    elif isinstance(node, list):
+        for item in node:
+            _round_positions(item, step)
+
+
+def _group_id(g: dict):
+    return g.get("group_id", g.get("gid"))
+
+
+def _rename_keys(node):
+    if isinstance(node, dict):
+        return {KEY_MAP.get(k, k): _rename_keys(v) for k, v in node.items()}
+    if isinstance(node, list):
+        return [_rename_keys(v) for v in node]
+    return node
+
+
+class StateCompressor:
+    def __init__(self, budget_tokens: int = cfg.STATE_TOKEN_BUDGET):
+        self.budget = budget_tokens
+        self.last = {}
+        self._ticks = 0
+        self._pre_total = 0
+        self._post_total = 0
+        self._over_budget = 0
+        self._steps = (
+            ("round", self._step_round),
+            ("slim", self._step_slim),
+            ("sectors", self._step_sectors),
+            ("keys", self._step_keys),
+            ("coarse", self._step_coarse),
+            ("trim", self._step_trim),
+            ("hard", self._step_hard),
+        )
+
+    # ─── Entrada principal ──────────────────────────────────
+    def compress(self, state: dict, grid) -> str:
+        """
+        Devuelve el estado serializado dentro del presupuesto. grid es el
+        SpatialGrid del tick (con las posiciones originales).
+        """
+        pre = estimate_tokens(json.dumps(state, ensure_ascii=False))
+        text = _dump(state)
+        applied = []
+
+        if estimate_tokens(text) > self.budget:
+            # Las reducciones modifican el estado: no tocar los snapshots delta
+            state = copy.deepcopy(state)
+            for name, step in self._steps:
+                step(state, grid)
+                text = _dump(state)
+                applied.append(name)
+                if estimate_tokens(text) <= self.budget:
+                    break
+
+        post = estimate_tokens(text)
+        self._record(pre, post, applied)
+        return text
+
+    def stats(self) -> dict:
+        n = max(1, self._ticks)
+        return {
+            "budget_tokens": self.budget,
+            "avg_pre_tokens": round(self._pre_total / n, 1),
+            "avg_post_tokens": round(self._post_total / n, 1),
+            "over_budget": self._over_budget,
+            "last": self.last
+        }
+
+    def _record(self, pre: int, post: int, applied: list):
+        self._ticks += 1
+        self._pre_total += pre
+        self._post_total += post
+        if post > self.budget:
+            self._over_budget += 1
+            log.warning(f"Estado de {post} tokens no cabe en el presupuesto ({self.budget})")
+        self.last = {"pre_tokens": pre, "post_tokens": post, "steps": applied}
+        if applied:
+            log.debug(f"Estado comprimido {pre} → {post} tokens ({', '.join(applied)})")
+
+    # ─── Reducciones, de menor a mayor pérdida ──────────────
+    def _step_round(self, state: dict, grid):
+        _round_positions(state, 1)
+
+    def _step_slim(self, state: dict, grid):
+        """Quita lo que no cambia: valores por defecto, listas de unidades y
+        campos del tick anterior iguales a los actuales."""
+        for section, defaults in SECTION_DEFAULTS.items():
+            for item in state.get(section, []):
+                for key, default in defaults.items():
+                    if key in item and item[key] == default:
+                        del item[key]
+        state["_defaults"] = SECTION_DEFAULTS
+
+        prev = state.get("_previous_tick_summary")
+        if prev:
+            current = {
+                "player_alive": sum(1 for p in state.get("players", []) if p.get("alive", True)),
+                "ai_groups": len(state.get("ai_groups", [])),
+                "events": [e.get("type") for e in state.get("events", [])],
+            }
+            changed = {k: v for k, v in prev.items() if k == "tick" or current.get(k) != v}
+            state["_previous_tick_summary"] = changed if len(changed) > 1 else {"tick": prev.get("tick"), "unchanged": True}
+
+    def _step_sectors(self, state: dict, grid):
+        """Agrupa por sector los grupos inactivos: sin eventos propios en el
+        tick y sin enemigos vivos a menos de COMPRESS_NEAR_DISTANCE."""
+        involved = {e.get("source_group") for e in state.get("events", [])}
+
+        keep, sectors = [], {}
+        for g in state.get("ai_groups", []):
+            pos = g.get("position")
+            faction = g.get("faction")
+            if (not _is_position(pos) or g.get("group_id") in involved
+                    or grid.nearest(pos, "players",
+                                    accept=lambda p: p.get("alive", True) and p.get("faction") != faction,
+                                    max_dist=cfg.COMPRESS_NEAR_DISTANCE)[1]):
+                keep.append(g)
+                continue
+
+            cell = grid.key(grid.cell_of(pos))
+            agg = sectors.setdefault((g.get("faction"), cell), {
+                "sector": cell, "faction": g.get("faction"),
+                "groups": 0, "units": 0, "x": 0.0, "z": 0.0, "group_ids": []
+            })
+            agg["groups"] += 1
+            agg["units"] += g.get("unit_count", 0)
+            agg["x"] += pos["x"]
+            agg["z"] += pos["z"]
+            agg["group_ids"].append(g.get("group_id"))
+
+        if not sectors:
+            return
+        for agg in sectors.values():
+            agg["center"] = {"x": int(agg.pop("x") / agg["groups"]), "z": int(agg.pop("z") / agg["groups"])}
+        state["ai_groups"] = keep
+        state["ai_sectors"] = list(sectors.values())
+        state["_sector_size_m"] = int(grid.cell_size)
+
+    def _step_keys(self, state: dict, grid):
+        for key in list(state.keys()):
+            if key not in PROTECTED_KEYS:
+                state[key] = _rename_keys(state[key])
+        state["_keys"] = {short: long for long, short in KEY_MAP.items()}
+
+    def _step_coarse(self, state: dict, grid):
+        _round_positions(state, 10)
+        events = state.get("events", [])
+        if len(events) > cfg.COMPRESS_MAX_EVENTS:
+            # El mod escribe primero los críticos: se conservan
+            state["events"] = events[:cfg.COMPRESS_MAX_EVENTS]
+            state["_events_omitted"] = len(events) - cfg.COMPRESS_MAX_EVENTS
+
+        meta = state.get("_meta", {})
+        if isinstance(meta.get("threat_events"), list):
+            counts = {}
+            for t in meta["threat_events"]:
+                counts[t] = counts.get(t, 0) + 1
+            meta["threat_events"] = counts
+        # Los sectores solo con IA ya están en ai_groups / ai_sectors
+        if isinstance(meta.get("sectors"), list):
+            meta["sectors"] = [sec for sec in meta["sectors"] if sec.get("players")]
+
+    def _step_trim(self, state: dict, grid):
+        """Último recurso: descartar lo más prescindible hasta caber."""
+        def distance(g) -> float:
+            pos = g.get("pos") or g.get("position")
+            return grid.nearest(pos, "players")[0] if _is_position(pos) else math.inf
+
+        def over() -> bool:
+            return estimate_tokens(_dump(state)) > self.budget
+
+        # "_keys" y "_defaults" explican los nombres cortos y los campos
+        # omitidos de pasos anteriores: nunca se recortan
+        if over():
+            state.pop("_previous_tick_summary", None)
+        while over() and state.get("events"):
+            state["events"].pop()
+            state["_events_omitted"] = state.get("_events_omitted", 0) + 1
+        meta = state.get("_meta", {})
+        for cluster in meta.get("player_clusters", []):
+            if over():
+                cluster.pop("players", None)
+        while over() and meta.get("sectors"):
+            meta["sectors"].pop()
+        while over() and state.get("ai_sectors"):
+            state["ai_sectors"].pop()
+        groups = state.get("ai_groups", [])
+        groups.sort(key=distance)
+        nearest = meta.get("nearest_enemy_m", {})
+        while over() and groups:
+            nearest.pop(_group_id(groups.pop()), None)
+            state["_groups_omitted"] = state.get("_groups_omitted", 0) + 1
+
+    def _step_hard(self, state: dict, grid):
+        """Garantía final: el contexto derivado, los jugadores más lejos de la
+        IA primero y las misiones. Solo la cabecera protegida y las leyendas se
+        conservan siempre (el presupuesto debe cubrirlas)."""
+        def distance(p) -> float:
+            pos = p.get("pos") or p.get("position")
+            return grid.nearest(pos, "groups")[0] if _is_position(pos) else math.inf
+
+        def over() -> bool:
+            return estimate_tokens(_dump(state)) > self.budget
+
+        for key in ("world_state", "_meta"):
+            if over():
+                state.pop(key, None)
+        players = state.get("players", [])
+        players.sort(key=distance)
+        while over() and players:
+            players.pop()
+            state["_players_omitted"] = state.get("_players_omitted", 0) + 1
+        missions = state.get("active_missions", [])
+        while over() and missions:
+            missions.pop()
+            state["_missions_omitted"] = state.get("_missions_omitted", 0) + 1
@@ -0,0 +1,159 @@
+"""
+strategic_planner.py — Planificación en dos niveles
+Un nivel estratégico lento (cada RAI_STRATEGIC_INTERVAL_S o ante eventos de
+misión) fija misiones, refuerzos e intenciones por grupo; un nivel táctico
+frecuente recibe solo los grupos en contacto con su intención y emite
+listas cortas de órdenes.
+"""
+
+import logging
+import time
+from collections import OrderedDict
+import config as cfg
+from game_state import SpatialGrid
+
+log = logging.getLogger("ReforgerAI.Tiers")
+
+VALID_INTENTS = {"ATTACK", "DEFEND", "PATROL", "FLANK", "AMBUSH", "RESERVE"}
+
+# Órdenes que acepta cada nivel; el resto se descarta
+STRATEGIC_COMMANDS = {
+    "CREATE_MISSION", "UPDATE_MISSION", "END_MISSION", "CALL_REINFORCEMENTS",
+    "SPAWN_GROUP", "DESPAWN_GROUP", "BROADCAST_MESSAGE", "TRIGGER_EVENT", "SET_WAYPOINT"
+}
+TACTICAL_COMMANDS = {"SET_FORMATION", "SET_WAYPOINT", "SET_BEHAVIOR", "SET_AMBUSH", "VEHICLE_ORDER"}
+
+# Eventos que obligan a revisar la estrategia antes de su intervalo
+STRATEGIC_EVENTS = {"MISSION_COMPLETED", "MISSION_FAILED", "OBJECTIVE_CAPTURED"}
+CONTACT_EVENTS = {"CONTACT_SPOTTED", "PLAYER_DOWNED", "VEHICLE_DESTROYED"}
+
+# Sesiones con plan recordado
+MAX_PLAN_SESSIONS = 32
+
+
+class SessionPlan:
+    def __init__(self):
+        self.intents = {}        # group_id -> {"intent", "objective", "mission_id"}
+        self.missions = set()    # misiones activas en la última revisión
+        self.revised_at = 0.0
+
+
+class TierPlanner:
+    def __init__(self):
+        self._sessions = OrderedDict()  # session_id -> SessionPlan
+        self.strategic_passes = 0
+        self.tactical_passes = 0
+        self.idle_ticks = 0
+        self.dropped = 0
+
+    def _plan(self, session_id: str) -> SessionPlan:
+        plan = self._sessions.get(session_id)
+        if plan is None:
+            plan = self._sessions[session_id] = SessionPlan()
+            if len(self._sessions) > MAX_PLAN_SESSIONS:
+                self._sessions.popitem(last=False)
+        else:
+            self._sessions.move_to_end(session_id)
+        return plan
+
+    # ─── Nivel estratégico ──────────────────────────────────
+    def strategic_due(self, gs: dict) -> bool:
+        plan = self._plan(gs["session_id"])
+        if not plan.revised_at or time.monotonic() - plan.revised_at >= cfg.STRATEGIC_INTERVAL_S:
+            return True
+        if any(e.get("type") in STRATEGIC_EVENTS for e in gs.get("events", [])):
+            return True
+        return {m.get("mission_id") for m in gs.get("active_missions", [])} != plan.missions
+
+    def apply_strategic(self, gs: dict, command: dict) -> dict:
+        """Guarda las intenciones de la respuesta estratégica y devuelve sus
+        órdenes de nivel estratégico."""
+        plan = self._plan(gs["session_id"])
+        groups = {g.get("group_id") for g in gs.get("ai_groups", [])}
+
+        intents = {}
+        raw = command.pop("intents", None)
+        for gid, intent in (raw.items() if isinstance(raw, dict) else ()):
+            if gid not in groups or not isinstance(intent, dict) or intent.get("intent") not in VALID_INTENTS:
+                continue
+            entry = {"intent": intent["intent"]}
+            if isinstance(intent.get("objective"), dict):
+                entry["objective"] = intent["objective"]
+            if intent.get("mission_id"):
+                entry["mission_id"] = intent["mission_id"]
+            intents[gid] = entry
+
+        plan.intents = intents
+        plan.missions = {m.get("mission_id") for m in gs.get("active_missions", [])}
+        plan.revised_at = time.monotonic()
+        self.strategic_passes += 1
+        log.debug(f"Revisión estratégica: {len(intents)}/{len(groups)} grupos con intención")
+
+        command["commands"] = self._keep(command.get("commands", []), STRATEGIC_COMMANDS, groups)
+        return command
+
+    # ─── Nivel táctico ──────────────────────────────────────
+    def tactical_state(self, gs: dict):
+        """GameState reducido a los grupos en contacto, o None si no hay ninguno."""
+        grid = SpatialGrid.from_state(gs)
+        plan = self._plan(gs["session_id"])
+        reported = {e.get("source_group") for e in gs.get("events", []) if e.get("type") in CONTACT_EVENTS}
+
+        groups, players = [], {}
+        for g in gs.get("ai_groups", []):
+            pos = g.get("position")
+            if not isinstance(pos, dict):
+                continue
+            faction = g.get("faction")
+            near = grid.within(pos, "players", cfg.TIER_CONTACT_RANGE)
+            enemies = [p for p in near if p.get("alive", True) and p.get("faction") != faction]
+            if not enemies and g.get("group_id") not in reported:
+                continue
+            group = dict(g)
+            group["intent"] = plan.intents.get(g.get("group_id"), {"intent": "SIN_ASIGNAR"})
+            groups.append(group)
+            for p in enemies:
+                players[p.get("id")] = p
+
+        if not groups:
+            self.idle_ticks += 1
+            return None
+
+        ids = {g.get("group_id") for g in groups}
+        state = {k: v for k, v in gs.items() if k not in ("players", "ai_groups", "events", "active_missions")}
+        state["players"] = list(players.values())
+        state["ai_groups"] = groups
+        state["events"] = [e for e in gs.get("events", [])
+                           if e.get("source_group") in ids or e.get("data", {}).get("player_id") in players]
+        state["_tier"] = {"level": "tactical", "max_commands": cfg.TACTICAL_MAX_COMMANDS}
+        return state
+
+    def apply_tactical(self, tactical_state: dict, command: dict) -> dict:
+        groups = {g.get("group_id") for g in tactical_state.get("ai_groups", [])}
+        self.tactical_passes += 1
+        commands = self._keep(command.get("commands", []), TACTICAL_COMMANDS, groups)
+        if len(commands) > cfg.TACTICAL_MAX_COMMANDS:
+            self.dropped += len(commands) - cfg.TACTICAL_MAX_COMMANDS
+            commands = commands[:cfg.TACTICAL_MAX_COMMANDS]
+        command["commands"] = commands
+        return command
+
+    def _keep(self, commands: list, allowed: set, groups: set) -> list:
+        """Órdenes del nivel permitidas; las de grupo, solo a grupos conocidos."""
+        out = []
+        for c in commands:
+            ctype = c.get("type") if isinstance(c, dict) else None
+            if ctype not in allowed or (ctype in TACTICAL_COMMANDS and c.get("target") not in groups):
+                self.dropped += 1
+                continue
+            out.append(c)
+        return out
+
+    def stats(self) -> dict:
+        return {
+            "strategic_passes": self.strategic_passes,
+            "tactical_passes": self.tactical_passes,
+            "idle_ticks": self.idle_ticks,
+            "dropped": self.dropped,
+            "sessions": len(self._sessions)
+        }
@@ -0,0 +1,251 @@
+"""
+tactical_planner.py — Planificador táctico por reglas
+Genera órdenes válidas en milisegundos a partir de posiciones, salud y
+eventos. Se usa cuando el LLM falla y, opcionalmente, en ticks rutinarios
+para no consultar al modelo si nada relevante ha cambiado.
+"""
+
+import logging
+import math
+import time
+from collections import OrderedDict
+import config as cfg
+from game_state import SpatialGrid
+
+log = logging.getLogger("ReforgerAI.Planner")
+
+# Prefijo de "reasoning" que identifica las órdenes del planificador
+PLANNER_TAG = "[planner]"
+
+# Eventos que exigen una decisión del LLM (no son rutina)
+SIGNIFICANT_EVENTS = {
+    "CONTACT_SPOTTED", "UNIT_KILLED", "PLAYER_DOWNED", "OBJECTIVE_CAPTURED",
+    "VEHICLE_DESTROYED", "MISSION_COMPLETED", "MISSION_FAILED",
+    "REINFORCEMENT_ARRIVED"
+}
+
+LOW_AMMO = {"LOW", "EMPTY"}
+
+# Comportamiento que el mod aplica junto a cada tipo de waypoint
+WAYPOINT_BEHAVIOR = {"RETREAT": "SAFE", "FLANK": "COMBAT"}
+
+# Sesiones con órdenes recordadas
+MAX_ORDER_SESSIONS = 32
+
+
+def _alive(p: dict) -> bool:
+    return p.get("alive", True)
+
+
+def _is_position(value) -> bool:
+    return isinstance(value, dict) and "x" in value and "z" in value
+
+
+class TacticalPlanner:
+    def __init__(self):
+        self.plans = 0
+        self.avg_ms = 0.0
+        # El mod no reporta formación, comportamiento ni waypoint de los
+        # grupos: se recuerdan las últimas órdenes enviadas a cada uno
+        self._orders = OrderedDict()  # session_id -> {group_id: {"formation", "behavior", "waypoint"}}
+
+    # ─── Órdenes ya enviadas ────────────────────────────────
+    def observe(self, session_id: str, commands: list):
+        """Registra las órdenes de grupo que se entregan al mod (del LLM o propias)."""
+        orders = self._session_orders(session_id)
+        for c in commands:
+            gid, params = c.get("target"), c.get("params") or {}
+            if not gid:
+                continue
+            o = orders.setdefault(gid, {})
+            t = c.get("type")
+            if t == "SET_FORMATION":
+                o["formation"] = params.get("formation")
+            elif t == "SET_BEHAVIOR":
+                o["behavior"] = params.get("behavior")
+            elif t in ("SET_WAYPOINT", "SET_AMBUSH") and _is_position(params.get("position")):
+                behavior = params.get("behavior") if t == "SET_WAYPOINT" else "DEFEND"
+                o["waypoint"] = (behavior, params["position"])
+                if t == "SET_AMBUSH":
+                    o["behavior"] = "STEALTH"
+                elif behavior in WAYPOINT_BEHAVIOR:
+                    o["behavior"] = WAYPOINT_BEHAVIOR[behavior]
+            elif t == "DESPAWN_GROUP":
+                orders.pop(gid, None)
+
+    def _session_orders(self, session_id: str) -> dict:
+        orders = self._orders.get(session_id)
+        if orders is None:
+            orders = self._orders[session_id] = {}
+            if len(self._orders) > MAX_ORDER_SESSIONS:
+                self._orders.popitem(last=False)
+        else:
+            self._orders.move_to_end(session_id)
+        return orders
+
+    # ─── ¿Puede resolverse este tick sin el LLM? ────────────
+    @staticmethod
+    def is_routine(gs: dict) -> bool:
+        if gs.get("urgent"):
+            return False
+        return not any(e.get("type") in SIGNIFICANT_EVENTS for e in gs.get("events", []))
+
+    # ─── Plan completo ──────────────────────────────────────
+    def plan(self, gs: dict, reason: str) -> dict:
+        """Devuelve un AICommand con "reasoning" marcado como del planificador."""
+        t0 = time.perf_counter()
+        grid = SpatialGrid.from_state(gs)
+        contacts = self._contacts_by_group(gs)
+        session_id = gs.get("session_id", "")
+
+        # Olvidar los grupos que ya no existen
+        orders = self._session_orders(session_id)
+        groups = gs.get("ai_groups", [])
+        alive = {g.get("group_id") for g in groups}
+        for gid in [gid for gid in orders if gid not in alive]:
+            del orders[gid]
+
+        commands, notes = [], []
+        for g in sorted(groups, key=lambda g: g.get("group_id", "")):
+            if len(commands) >= cfg.PLANNER_MAX_COMMANDS:
+                break
+            cmds, note = self._plan_group(g, grid, contacts, orders.get(g.get("group_id"), {}))
+            if cmds:
+                commands.extend(cmds)
+                notes.append(note)
+
+        commands = commands[:cfg.PLANNER_MAX_COMMANDS]
+        self.observe(session_id, commands)
+        elapsed = (time.perf_counter() - t0) * 1000
+        self.plans += 1
+        self.avg_ms += (elapsed - self.avg_ms) / self.plans
+        log.debug(f"Plan ({reason}) en {elapsed:.1f}ms — {len(commands)} comandos")
+
+        summary = "; ".join(notes) if notes else "sin cambios"
+        return {
+            "command_id": f"planner_{gs.get('tick', int(time.time()))}",
+            "timestamp": time.time(),
+            "reasoning": f"{PLANNER_TAG} {reason}: {summary}",
+            "commands": commands
+        }
+
+    # ─── Reglas por grupo ───────────────────────────────────
+    def _plan_group(self, g: dict, grid: SpatialGrid, contacts: dict, last: dict):
+        """Órdenes para el grupo; last son las últimas que se le enviaron."""
+        gid = g.get("group_id")
+        pos = g.get("position")
+        if not gid or not isinstance(pos, dict):
+            return [], ""
+
+        faction = g.get("faction")
+        dist, enemy = grid.nearest(pos, "players",
+                                   accept=lambda p: _alive(p) and p.get("faction") != faction,
+                                   max_dist=cfg.SPATIAL_ENGAGE_RANGE)
+        # El contacto reportado por el propio grupo manda sobre el jugador más cercano
+        if gid in contacts:
+            enemy_pos = contacts[gid]
+            contact_dist = math.hypot(enemy_pos["x"] - pos["x"], enemy_pos["z"] - pos["z"])
+        elif enemy:
+            enemy_pos, contact_dist = enemy["position"], dist
+        else:
+            return [], ""
+
+        health = g.get("health_avg", 100)
+        weak = health < cfg.PLANNER_RETREAT_HEALTH or g.get("ammo_status") in LOW_AMMO
+
+        # Debilitado y con el enemigo cerca: replegarse (una vez por repliegue:
+        # solo se ordena otro al llegar al punto anterior)
+        if weak and contact_dist <= cfg.PLANNER_CONTACT_RANGE:
+            if self._heading_to(last, "RETREAT") and not self._near(last, pos):
+                return [], ""
+            return [self._waypoint(gid, self._away(pos, enemy_pos), "RETREAT")], f"{gid} se repliega"
+
+        # En contacto: asaltar si está entero, si no defender la posición
+        if contact_dist <= cfg.PLANNER_CONTACT_RANGE:
+            if weak:
+                if self._heading_to(last, "DEFEND"):
+                    return [], ""
+                return [self._behavior(gid, "COMBAT"),
+                        self._waypoint(gid, pos, "DEFEND")], f"{gid} defiende"
+            cmds = []
+            if last.get("formation") != "LINE":
+                cmds.append(self._formation(gid, "LINE"))
+            # No repetir un asalto que ya va hacia el mismo punto
+            if not (self._heading_to(last, "ASSAULT") and self._near(last, enemy_pos)):
+                cmds.append(self._waypoint(gid, enemy_pos, "ASSAULT"))
+            if not cmds:
+                return [], ""
+            return cmds, f"{gid} asalta contacto a {contact_dist:.0f}m"
+
+        # Enemigo dentro del alcance: alerta y formación de avance, sin
+        # deshacer un asalto o un repliegue en curso
+        if self._heading_to(last, "ASSAULT") or self._heading_to(last, "RETREAT"):
+            return [], ""
+        cmds = []
+        if last.get("formation") != "WEDGE":
+            cmds.append(self._formation(gid, "WEDGE"))
+        if last.get("behavior") != "AWARE":
+            cmds.append(self._behavior(gid, "AWARE"))
+        if not cmds:
+            return [], ""
+        return cmds, f"{gid} en alerta ({contact_dist:.0f}m)"
+
+    @staticmethod
+    def _contacts_by_group(gs: dict) -> dict:
+        """Última posición enemiga reportada por cada grupo."""
+        out = {}
+        for e in gs.get("events", []):
+            if e.get("type") != "CONTACT_SPOTTED":
+                continue
+            enemy_pos = e.get("data", {}).get("enemy_position")
+            if e.get("source_group") and isinstance(enemy_pos, dict):
+                out[e["source_group"]] = enemy_pos
+        return out
+
+    @staticmethod
+    def _heading_to(last: dict, behavior: str) -> bool:
+        """¿El último waypoint enviado al grupo es de ese tipo?"""
+        wp = last.get("waypoint")
+        return wp is not None and wp[0] == behavior
+
+    @staticmethod
+    def _near(last: dict, target: dict) -> bool:
+        """¿Está el último waypoint del grupo a menos de la tolerancia de target?"""
+        wp = last.get("waypoint")
+        if wp is None:
+            return False
+        pos = wp[1]
+        return math.hypot(pos["x"] - target["x"], pos["z"] - target["z"]) <= cfg.PLANNER_WAYPOINT_TOLERANCE
+
+    @staticmethod
+    def _away(pos: dict, threat: dict) -> dict:
+        dx, dz = pos["x"] - threat["x"], pos["z"] - threat["z"]
+        norm = math.hypot(dx, dz) or 1.0
+        d = cfg.PLANNER_RETREAT_DISTANCE
+
+        def clamp(v):
+            # Junto al borde, la retirada se queda dentro del mapa
+            return round(min(max(v, cfg.MAP_MIN_COORD), cfg.MAP_MAX_COORD), 1)
+
+        return {"x": clamp(pos["x"] + dx / norm * d), "y": pos.get("y", 0.0),
+                "z": clamp(pos["z"] + dz / norm * d)}
+
+    # ─── Constructores de comandos ──────────────────────────
+    @staticmethod
+    def _waypoint(gid: str, pos: dict, behavior: str) -> dict:
+        return {
+            "type": "SET_WAYPOINT",
+            "target": gid,
+            "params": {
+                "position": {"x": pos["x"], "y": pos.get("y", 0.0), "z": pos["z"]},
+                "behavior": behavior
+            }
+        }
+
+    @staticmethod
+    def _formation(gid: str, formation: str) -> dict:
+        return {"type": "SET_FORMATION", "target": gid, "params": {"formation": formation}}
+
+    @staticmethod
+    def _behavior(gid: str, behavior: str) -> dict:
+        return {"type": "SET_BEHAVIOR", "target": gid, "params": {"behavior": behavior}}
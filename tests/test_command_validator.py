@@ -0,0 +1,90 @@
+"""
+test_command_validator.py — Validación de órdenes del LLM (CommandValidator)
+"""
+
+import logging
+import unittest
+
+from command_executor import CommandValidator
+
+STATE = {
+    "ai_groups": [{"group_id": "grp_a"}, {"group_id": "grp_b"}],
+    "active_missions": [{"mission_id": "mission_000"}],
+}
+
+
+def waypoint(target: str = "grp_a", x: float = 500, z: float = 500, behavior: str = "PATROL") -> dict:
+    return {"type": "SET_WAYPOINT", "target": target,
+            "params": {"position": {"x": x, "y": 0, "z": z}, "behavior": behavior}}
+
+
+class CommandValidatorTest(unittest.TestCase):
+    def setUp(self):
+        # Los rechazos se registran como warning: no ensuciar la salida
+        logging.getLogger("ReforgerAI").setLevel(logging.CRITICAL)
+        self.validator = CommandValidator(min_coord=0, max_coord=1000)
+        self.ids = CommandValidator.entities(STATE)
+
+    def reason(self, c):
+        return self.validator.check(c, self.ids)
+
+    def test_valid_commands(self):
+        self.assertIsNone(self.reason(waypoint()))
+        self.assertIsNone(self.reason({"type": "SET_FORMATION", "target": "grp_b",
+                                       "params": {"formation": "WEDGE"}}))
+        self.assertIsNone(self.reason({"type": "UPDATE_MISSION", "target": "mission_000", "params": {}}))
+
+    def test_map_bounds_inclusive(self):
+        self.assertIsNone(self.reason(waypoint(x=0, z=1000)))
+        self.assertEqual(self.reason(waypoint(x=-1)), "'position' fuera del mapa")
+        self.assertEqual(self.reason(waypoint(z=1000.5)), "'position' fuera del mapa")
+
+    def test_position_shape(self):
+        c = waypoint()
+        del c["params"]["position"]["z"]
+        self.assertEqual(self.reason(c), "'position' sin z")
+        c["params"]["position"] = "500,500"
+        self.assertEqual(self.reason(c), "'position' no es posición")
+        c["params"]["position"] = {"x": True, "z": 1}
+        self.assertEqual(self.reason(c), "'position' sin x")
+
+    def test_unknown_targets(self):
+        self.assertEqual(self.reason(waypoint(target="grp_zz")), "grupo desconocido")
+        self.assertEqual(self.reason({"type": "END_MISSION", "target": "mission_999", "params": {}}),
+                         "misión desconocida")
+
+    def test_assign_mission_must_exist(self):
+        spawn = {"type": "SPAWN_GROUP", "target": "", "params": {
+            "faction": "USSR", "template": "squad", "position": {"x": 1, "y": 0, "z": 1},
+            "assign_mission": "mission_999"}}
+        self.assertEqual(self.reason(spawn), "assign_mission desconocida")
+        spawn["params"]["assign_mission"] = "mission_000"
+        self.assertIsNone(self.reason(spawn))
+
+    def test_required_enum_and_types(self):
+        self.assertEqual(self.reason(waypoint(behavior="DANCE")), "'behavior' inválido")
+        c = waypoint()
+        del c["params"]["behavior"]
+        self.assertEqual(self.reason(c), "falta 'behavior'")
+        self.assertEqual(self.reason({"type": "CALL_REINFORCEMENTS", "target": "", "params": {
+            "faction": "USSR", "position": {"x": 1, "y": 0, "z": 1}, "group_count": "2"}}),
+            "'group_count' con tipo inválido")
+
+    def test_malformed(self):
+        self.assertEqual(self.reason("SET_WAYPOINT"), "no es objeto")
+        self.assertEqual(self.reason({"type": "TELEPORT"}), "tipo desconocido")
+        self.assertEqual(self.reason({"type": "SET_BEHAVIOR", "target": "grp_a", "params": []}),
+                         "params no es objeto")
+
+    def test_filter_keeps_valid_and_counts_reasons(self):
+        valid, rejected = self.validator.filter(
+            [waypoint(), waypoint(x=5000), waypoint(target="grp_zz"), waypoint(target="grp_b")], STATE)
+        self.assertEqual([c["target"] for c in valid], ["grp_a", "grp_b"])
+        self.assertEqual(rejected, 2)
+        stats = self.validator.stats()
+        self.assertEqual(stats["checked"], 4)
+        self.assertEqual(stats["rejected"], {"'position' fuera del mapa": 1, "grupo desconocido": 1})
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,93 @@
+"""
+test_delta.py — Reconstrucción de estados delta (StateReconstructor)
+"""
+
+import unittest
+
+from game_state import StateReconstructor
+
+
+def keyframe(tick: int) -> dict:
+    return {
+        "session_id": "s1", "tick": tick, "timestamp": 1.0, "delta": False,
+        "players": [
+            {"id": "player_1", "position": {"x": 100, "y": 0, "z": 100}},
+            {"id": "player_2", "position": {"x": 200, "y": 0, "z": 200}},
+        ],
+        "ai_groups": [
+            {"group_id": "grp_a", "unit_count": 4},
+            {"group_id": "grp_b", "unit_count": 6},
+        ],
+        "active_missions": [{"mission_id": "mission_000", "type": "DEFEND"}],
+    }
+
+
+def by_id(items: list, key: str) -> dict:
+    return {e[key]: e for e in items}
+
+
+class StateReconstructorTest(unittest.TestCase):
+    def setUp(self):
+        self.rec = StateReconstructor(history=4)
+
+    def test_keyframe_passes_through(self):
+        gs = keyframe(1)
+        self.assertIs(self.rec.reconstruct(gs), gs)
+
+    def test_delta_merges_changes_and_removals(self):
+        self.rec.reconstruct(keyframe(1))
+        delta = {
+            "session_id": "s1", "tick": 2, "timestamp": 2.0, "delta": True, "base_tick": 1,
+            "players": [{"id": "player_1", "position": {"x": 150, "y": 0, "z": 100}}],
+            "ai_groups": [{"group_id": "grp_c", "unit_count": 2}],
+            "active_missions": [],
+            "removed": {"players": [], "ai_groups": ["grp_b"], "active_missions": []},
+        }
+        full = self.rec.reconstruct(delta)
+
+        self.assertNotIn("delta", full)
+        self.assertNotIn("base_tick", full)
+        self.assertNotIn("removed", full)
+        players = by_id(full["players"], "id")
+        self.assertEqual(players["player_1"]["position"]["x"], 150)
+        self.assertIn("player_2", players)
+        self.assertEqual(set(by_id(full["ai_groups"], "group_id")), {"grp_a", "grp_c"})
+        self.assertEqual(len(full["active_missions"]), 1)
+
+    def test_delta_chain_uses_acknowledged_base(self):
+        self.rec.reconstruct(keyframe(1))
+        self.rec.reconstruct({"session_id": "s1", "tick": 2, "delta": True, "base_tick": 1,
+                              "removed": {"ai_groups": ["grp_a"]}})
+        # El mod puede seguir usando la base 1 si el tick 2 no se confirmó
+        full = self.rec.reconstruct({"session_id": "s1", "tick": 3, "delta": True, "base_tick": 1})
+        self.assertEqual(set(by_id(full["ai_groups"], "group_id")), {"grp_a", "grp_b"})
+        # ... o el 2, ya sin grp_a
+        full = self.rec.reconstruct({"session_id": "s1", "tick": 4, "delta": True, "base_tick": 2})
+        self.assertEqual(set(by_id(full["ai_groups"], "group_id")), {"grp_b"})
+
+    def test_removed_accepts_id_objects(self):
+        self.rec.reconstruct(keyframe(1))
+        full = self.rec.reconstruct({"session_id": "s1", "tick": 2, "delta": True, "base_tick": 1,
+                                     "removed": {"players": [{"id": "player_2"}]}})
+        self.assertEqual(set(by_id(full["players"], "id")), {"player_1"})
+
+    def test_unknown_base_requests_keyframe(self):
+        self.rec.reconstruct(keyframe(1))
+        self.assertIsNone(self.rec.reconstruct(
+            {"session_id": "s1", "tick": 2, "delta": True, "base_tick": 99}))
+        # Las sesiones no comparten bases
+        self.assertIsNone(self.rec.reconstruct(
+            {"session_id": "s2", "tick": 2, "delta": True, "base_tick": 1}))
+
+    def test_old_bases_expire(self):
+        self.rec.reconstruct(keyframe(1))
+        for tick in range(2, 7):
+            self.rec.reconstruct({"session_id": "s1", "tick": tick, "delta": True, "base_tick": tick - 1})
+        self.assertIsNone(self.rec.reconstruct(
+            {"session_id": "s1", "tick": 7, "delta": True, "base_tick": 1}))
+        self.assertIsNotNone(self.rec.reconstruct(
+            {"session_id": "s1", "tick": 8, "delta": True, "base_tick": 6}))
+
+
+if __name__ == "__main__":
+    unittest.main()
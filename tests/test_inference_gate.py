@@ -0,0 +1,91 @@
+"""
+test_inference_gate.py — Turnos por sesión y límite global (InferenceGate)
+"""
+
+import asyncio
+import unittest
+
+from command_stream import InferenceGate
+
+
+async def settle():
+    # Deja correr las tareas pendientes hasta que se bloqueen
+    for _ in range(5):
+        await asyncio.sleep(0)
+
+
+class InferenceGateTest(unittest.IsolatedAsyncioTestCase):
+    async def test_newer_state_supersedes_waiting_one(self):
+        gate = InferenceGate(max_concurrent=4)
+        self.assertTrue(await gate.acquire("s1"))
+
+        second = asyncio.create_task(gate.acquire("s1"))
+        await settle()
+        third = asyncio.create_task(gate.acquire("s1"))
+        await settle()
+
+        # El segundo estado se descarta sin llegar a Ollama
+        self.assertFalse(await second)
+        self.assertFalse(third.done())
+        self.assertEqual(gate.stats()["superseded"], 1)
+
+        # Al terminar la inferencia, el turno pasa al más reciente
+        gate.release("s1")
+        self.assertTrue(await third)
+        gate.release("s1")
+        self.assertEqual(gate.stats()["active"], 0)
+
+    async def test_sessions_do_not_supersede_each_other(self):
+        gate = InferenceGate(max_concurrent=2)
+        self.assertTrue(await gate.acquire("s1"))
+        self.assertTrue(await gate.acquire("s2"))
+        self.assertEqual(gate.stats()["superseded"], 0)
+        gate.release("s1")
+        gate.release("s2")
+
+    async def test_global_cap(self):
+        gate = InferenceGate(max_concurrent=1)
+        self.assertTrue(await gate.acquire("s1"))
+
+        other = asyncio.create_task(gate.acquire("s2"))
+        await settle()
+        self.assertFalse(other.done())
+        self.assertEqual(gate.stats()["queue_depth"], 1)
+
+        gate.release("s1")
+        self.assertTrue(await other)
+        gate.release("s2")
+
+    async def test_cancelled_waiter_frees_session(self):
+        gate = InferenceGate(max_concurrent=4)
+        self.assertTrue(await gate.acquire("s1"))
+        waiter = asyncio.create_task(gate.acquire("s1"))
+        await settle()
+        waiter.cancel()
+        with self.assertRaises(asyncio.CancelledError):
+            await waiter
+        gate.release("s1")
+
+        # Sin turnos colgados: la sesión vuelve a entrar sin esperar
+        self.assertTrue(await asyncio.wait_for(gate.acquire("s1"), 1))
+        gate.release("s1")
+
+    async def test_extra_slots_count_against_cap(self):
+        gate = InferenceGate(max_concurrent=2)
+        self.assertTrue(await gate.acquire("s1"))
+        await gate.acquire_slot()
+        self.assertEqual(gate.stats()["active"], 2)
+
+        other = asyncio.create_task(gate.acquire("s2"))
+        await settle()
+        self.assertFalse(other.done())
+
+        gate.release_slot()
+        self.assertTrue(await other)
+        gate.release("s1")
+        gate.release("s2")
+        self.assertEqual(gate.stats()["extra_slots"], 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
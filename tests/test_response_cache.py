@@ -0,0 +1,109 @@
+"""
+test_response_cache.py — Caché de órdenes por situación (ResponseCache)
+"""
+
+import copy
+import unittest
+
+import config as cfg
+from response_cache import CACHE_TAG, ResponseCache
+
+
+def state(tick: int = 1, players: int = 4, session: str = "s1") -> dict:
+    return {
+        "session_id": session, "tick": tick,
+        "players": [{"id": f"player_{i}", "faction": "US", "alive": True,
+                     "position": {"x": 1000 + i * 300, "y": 0, "z": 1000}} for i in range(players)],
+        "ai_groups": [
+            {"group_id": "grp_a", "position": {"x": 2000, "y": 0, "z": 2000}, "health_avg": 100},
+            {"group_id": "grp_b", "position": {"x": 3000, "y": 0, "z": 2000}, "health_avg": 90},
+        ],
+        "events": [],
+        "active_missions": [{"mission_id": "mission_000", "status": "ACTIVE"}],
+    }
+
+
+COMMAND = {
+    "reasoning": "Cubrir el flanco",
+    "commands": [
+        {"type": "SET_FORMATION", "target": "grp_a", "params": {"formation": "LINE"}},
+        {"type": "SPAWN_GROUP", "target": "", "params": {"faction": "USSR", "template": "squad",
+                                                        "position": {"x": 1, "y": 0, "z": 1}}},
+    ]
+}
+
+
+class ResponseCacheTest(unittest.TestCase):
+    def test_exact_hit_replays_group_orders_only(self):
+        cache = ResponseCache(similarity=1.0)
+        cache.store(state(), COMMAND)
+        hit = cache.lookup(state(tick=2))
+
+        self.assertEqual([c["type"] for c in hit["commands"]], ["SET_FORMATION"])
+        self.assertTrue(hit["reasoning"].startswith(CACHE_TAG))
+        self.assertEqual(hit["command_id"], "cache_2")
+        self.assertEqual(cache.stats()["hits"], 1)
+
+    def test_hit_is_a_copy(self):
+        cache = ResponseCache(similarity=1.0)
+        cache.store(state(), COMMAND)
+        cache.lookup(state())["commands"][0]["params"]["formation"] = "COLUMN"
+        self.assertEqual(cache.lookup(state())["commands"][0]["params"]["formation"], "LINE")
+
+    def test_small_moves_stay_in_the_same_cell(self):
+        cache = ResponseCache(similarity=1.0)
+        cache.store(state(), COMMAND)
+        moved = state()
+        moved["ai_groups"][0]["position"]["x"] += cfg.CACHE_CELL_SIZE / 10
+        self.assertIsNotNone(cache.lookup(moved))
+
+    def test_near_hit_above_threshold(self):
+        cache = ResponseCache(similarity=0.8)
+        cache.store(state(players=8), COMMAND)
+        changed = state(players=8)
+        changed["players"][0]["position"]["z"] += 5 * cfg.CACHE_CELL_SIZE
+
+        self.assertIsNotNone(cache.lookup(changed))
+        self.assertEqual(cache.stats()["near_hits"], 1)
+
+    def test_near_miss_below_threshold(self):
+        cache = ResponseCache(similarity=0.95)
+        cache.store(state(players=8), COMMAND)
+        changed = state(players=8)
+        changed["players"][0]["position"]["z"] += 5 * cfg.CACHE_CELL_SIZE
+        self.assertIsNone(cache.lookup(changed))
+
+    def test_near_hit_requires_same_groups(self):
+        cache = ResponseCache(similarity=0.1)
+        cache.store(state(), COMMAND)
+        other = state()
+        other["ai_groups"][1]["group_id"] = "grp_c"
+        self.assertIsNone(cache.lookup(other))
+
+    def test_sessions_are_isolated(self):
+        cache = ResponseCache(similarity=0.5)
+        cache.store(state(), COMMAND)
+        self.assertIsNone(cache.lookup(state(session="s2")))
+
+    def test_expired_entries_miss(self):
+        cache = ResponseCache(similarity=1.0, ttl_s=-1)
+        cache.store(state(), COMMAND)
+        self.assertIsNone(cache.lookup(state()))
+
+    def test_nothing_stored_without_replayable_orders(self):
+        cache = ResponseCache(similarity=1.0)
+        only_spawn = copy.deepcopy(COMMAND)
+        only_spawn["commands"] = only_spawn["commands"][1:]
+        cache.store(state(), only_spawn)
+        self.assertEqual(cache.stats()["size"], 0)
+
+    def test_lru_capacity(self):
+        cache = ResponseCache(capacity=2, similarity=1.0)
+        for n in (1, 2, 3):
+            cache.store(state(players=n), COMMAND)
+        self.assertEqual(cache.stats()["size"], 2)
+        self.assertIsNone(cache.lookup(state(players=1)))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,112 @@
+"""
+test_sharding.py — Concentraciones de jugadores y fusión de órdenes por sector
+"""
+
+import unittest
+
+import config as cfg
+from game_state import SpatialGrid
+from sharding import ShardPlanner
+
+
+def player(pid: int, x: float, z: float, alive: bool = True) -> dict:
+    return {"id": f"player_{pid}", "alive": alive, "position": {"x": x, "y": 0, "z": z}}
+
+
+class PlayerClustersTest(unittest.TestCase):
+    def clusters(self, players: list, radius: float = 150, cell_size: float = 100) -> list:
+        grid = SpatialGrid.from_state({"players": players}, cell_size=cell_size)
+        return grid.player_clusters(radius)
+
+    def test_chains_players_across_cells(self):
+        # 0-1-2 encadenados a 120 m (distintas celdas); 3 y 4 aparte
+        players = [player(0, 0, 0), player(1, 120, 0), player(2, 240, 0),
+                   player(3, 5000, 5000), player(4, 5100, 5000)]
+        clusters = self.clusters(players)
+
+        self.assertEqual([c["size"] for c in clusters], [3, 2])
+        self.assertEqual(sorted(clusters[0]["players"]), ["player_0", "player_1", "player_2"])
+        self.assertEqual(clusters[0]["center"], {"x": 120, "z": 0})
+        self.assertEqual(clusters[1]["center"], {"x": 5050, "z": 5000})
+
+    def test_gap_larger_than_radius_splits(self):
+        clusters = self.clusters([player(0, 0, 0), player(1, 151, 0)])
+        self.assertEqual([c["size"] for c in clusters], [1, 1])
+
+    def test_dead_players_ignored(self):
+        clusters = self.clusters([player(0, 0, 0), player(1, 100, 0, alive=False), player(2, 200, 0)])
+        self.assertEqual(sorted(len(c["players"]) for c in clusters), [1, 1])
+
+    def test_empty(self):
+        self.assertEqual(self.clusters([]), [])
+
+
+def part(sector: int, groups: list, missions: list, commands: list) -> tuple:
+    shard_state = {
+        "_shard": {"sector": sector},
+        "ai_groups": [{"group_id": g} for g in groups],
+        "active_missions": [{"mission_id": m} for m in missions],
+    }
+    return shard_state, {"reasoning": f"r{sector}", "commands": commands}
+
+
+def cmd(ctype: str, target: str = "") -> dict:
+    return {"type": ctype, "target": target, "params": {}}
+
+
+class ShardMergeTest(unittest.TestCase):
+    def setUp(self):
+        self.planner = ShardPlanner()
+
+    def test_group_orders_only_from_owner(self):
+        merged, dropped = self.planner.merge([
+            part(1, ["grp_a"], [], [cmd("SET_BEHAVIOR", "grp_a"), cmd("SET_BEHAVIOR", "grp_b")]),
+            part(2, ["grp_b"], [], [cmd("SET_BEHAVIOR", "grp_b"), cmd("SET_FORMATION", "grp_a")]),
+        ])
+        self.assertEqual([(c["type"], c["target"]) for c in merged["commands"]],
+                         [("SET_BEHAVIOR", "grp_a"), ("SET_BEHAVIOR", "grp_b")])
+        self.assertEqual(dropped, 2)
+        self.assertEqual(merged["reasoning"], "[sector 1] r1 [sector 2] r2")
+
+    def test_one_order_per_type_and_group(self):
+        merged, dropped = self.planner.merge([
+            part(1, ["grp_a"], [], [cmd("SET_WAYPOINT", "grp_a"), cmd("SET_WAYPOINT", "grp_a"),
+                                    cmd("SET_FORMATION", "grp_a")]),
+        ])
+        self.assertEqual(len(merged["commands"]), 2)
+        self.assertEqual(dropped, 1)
+
+    def test_global_limits(self):
+        spawns = [cmd("SPAWN_GROUP"), cmd("CALL_REINFORCEMENTS")] * cfg.SHARD_MAX_SPAWNS
+        merged, dropped = self.planner.merge([
+            part(1, ["grp_a"], [], [cmd("BROADCAST_MESSAGE"), cmd("CREATE_MISSION")] + spawns),
+            part(2, ["grp_b"], [], [cmd("BROADCAST_MESSAGE"), cmd("TRIGGER_EVENT"), cmd("TRIGGER_EVENT")]),
+        ])
+        types = [c["type"] for c in merged["commands"]]
+        self.assertEqual(types.count("BROADCAST_MESSAGE"), 1)
+        self.assertEqual(types.count("CREATE_MISSION"), 1)
+        self.assertEqual(types.count("TRIGGER_EVENT"), 1)
+        # Refuerzos y spawns comparten límite
+        self.assertEqual(types.count("SPAWN_GROUP") + types.count("CALL_REINFORCEMENTS"),
+                         cfg.SHARD_MAX_SPAWNS)
+        self.assertEqual(dropped, cfg.SHARD_MAX_SPAWNS + 2)
+
+    def test_mission_orders_only_from_owner(self):
+        merged, dropped = self.planner.merge([
+            part(1, ["grp_a"], ["mission_000"], [cmd("UPDATE_MISSION", "mission_000")]),
+            part(2, ["grp_b"], [], [cmd("END_MISSION", "mission_000")]),
+        ])
+        self.assertEqual([c["type"] for c in merged["commands"]], ["UPDATE_MISSION"])
+        self.assertEqual(dropped, 1)
+
+    def test_vehicle_orders_first_shard_wins(self):
+        merged, dropped = self.planner.merge([
+            part(1, ["grp_a"], [], [cmd("VEHICLE_ORDER", "veh_1")]),
+            part(2, ["grp_b"], [], [cmd("VEHICLE_ORDER", "veh_1"), cmd("VEHICLE_ORDER", "veh_2")]),
+        ])
+        self.assertEqual([c["target"] for c in merged["commands"]], ["veh_1", "veh_2"])
+        self.assertEqual(dropped, 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
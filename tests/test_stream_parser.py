@@ -0,0 +1,66 @@
+"""
+test_stream_parser.py — Extracción incremental de comandos (IncrementalCommandParser)
+"""
+
+import json
+import unittest
+
+from llm_client import IncrementalCommandParser
+
+RESPONSE = json.dumps({
+    "reasoning": "Flanquear por el norte {sin cerrar [",
+    "commands": [
+        {"type": "SET_FORMATION", "target": "grp_a", "params": {"formation": "WEDGE"}},
+        {"type": "BROADCAST_MESSAGE", "target": "all",
+         "params": {"message": "dice \"alto\" } ] {", "duration": 5}},
+        {"type": "SET_WAYPOINT", "target": "grp_b",
+         "params": {"position": {"x": 1, "y": 2, "z": 3}, "behavior": "FLANK"}},
+    ]
+})
+EXPECTED = json.loads(RESPONSE)["commands"]
+
+
+def feed_in_chunks(text: str, size: int) -> list:
+    parser = IncrementalCommandParser()
+    out = []
+    for i in range(0, len(text), size):
+        out.extend(parser.feed(text[i:i + size]))
+    return out
+
+
+class IncrementalCommandParserTest(unittest.TestCase):
+    def test_whole_response(self):
+        self.assertEqual(IncrementalCommandParser().feed(RESPONSE), EXPECTED)
+
+    def test_any_chunk_size(self):
+        # Cortes en cualquier punto: dentro de claves, cadenas y escapes
+        for size in (1, 2, 3, 7, 16, 64):
+            with self.subTest(size=size):
+                self.assertEqual(feed_in_chunks(RESPONSE, size), EXPECTED)
+
+    def test_commands_emitted_as_they_close(self):
+        parser = IncrementalCommandParser()
+        first = json.dumps(EXPECTED[0])
+        head = '{"reasoning": "x", "commands": [' + first
+        self.assertEqual(parser.feed(head[:-1]), [])
+        self.assertEqual(parser.feed(head[-1:]), [EXPECTED[0]])
+
+    def test_stops_at_end_of_array(self):
+        parser = IncrementalCommandParser()
+        out = parser.feed('{"commands": [{"type": "A"}], "extra": [{"type": "B"}]}')
+        self.assertEqual(out, [{"type": "A"}])
+        self.assertEqual(parser.feed('{"type": "C"}'), [])
+
+    def test_invalid_command_skipped(self):
+        out = IncrementalCommandParser().feed('{"commands": [{"type": "A",}, {"type": "B"}]}')
+        self.assertEqual(out, [{"type": "B"}])
+
+    def test_buffer_keeps_full_text(self):
+        parser = IncrementalCommandParser()
+        for i in range(0, len(RESPONSE), 5):
+            parser.feed(RESPONSE[i:i + 5])
+        self.assertEqual(json.loads(parser.buffer), json.loads(RESPONSE))
+
+
+if __name__ == "__main__":
+    unittest.main()